@@ -0,0 +1,162 @@
+// Compares the concurrent buddy allocator against the sequential one behind a single mutex, build and run with:
+//
+//     cc -std=gnu11 -O2 -o bench_concurrent_buddy buddy_alloc/bench_concurrent_buddy.c
+//         buddy_alloc/concurrent_buddy_alloc.c buddy_alloc/buddy_alloc.c -lpthread
+//     ./bench_concurrent_buddy [max_threads]
+//
+// Every thread keeps a window of live blocks of 16 bytes to about 2 KiB and replaces the oldest one on every step, so
+// splits and merges happen all the time on every order. The thread count doubles up to the number of online cores,
+// which is also run itself when it is not a power of two. A larger max_threads oversubscribes the cores.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "buddy_alloc.h"
+#include "concurrent_buddy_alloc.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_STEPS (1 << 20)
+#define BENCH_LIVE 64
+#define BENCH_BUFFER_SIZE (64*1024*1024)
+
+typedef struct Bench_Thread Bench_Thread;
+struct Bench_Thread {
+    pthread_t thread;
+    bool concurrent;
+    uint64_t seed;
+};
+
+static _Alignas(4096) unsigned char bench_buffer[BENCH_BUFFER_SIZE];
+
+static Concurrent_Buddy bench_concurrent;
+static Buddy_Allocator bench_sequential;
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t bench_size(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (size_t)16 << (*state % 8) | (size_t)(*state >> 32) % 16;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void *bench_alloc(bool concurrent, size_t size) {
+    void *ptr;
+
+    if(concurrent) {
+        return concurrent_buddy_alloc(&bench_concurrent, size);
+    }
+
+    pthread_mutex_lock(&bench_lock);
+    ptr = buddy_allocator_alloc(&bench_sequential, size);
+    pthread_mutex_unlock(&bench_lock);
+
+    return ptr;
+}
+
+static void bench_free(bool concurrent, void *ptr) {
+    if(concurrent) {
+        concurrent_buddy_free(&bench_concurrent, ptr);
+        return;
+    }
+
+    pthread_mutex_lock(&bench_lock);
+    buddy_allocator_free(&bench_sequential, ptr);
+    pthread_mutex_unlock(&bench_lock);
+}
+
+static void *bench_thread(void *arg) {
+    Bench_Thread *t = (Bench_Thread *)arg;
+    uint64_t state = t->seed;
+    void *live[BENCH_LIVE] = {0};
+
+    for(size_t i = 0; i < BENCH_STEPS; i++) {
+        void **slot = &live[i % BENCH_LIVE];
+
+        if(*slot != NULL) {
+            bench_free(t->concurrent, *slot);
+        }
+        *slot = bench_alloc(t->concurrent, bench_size(&state));
+        assert(*slot != NULL);
+    }
+    for(size_t i = 0; i < BENCH_LIVE; i++) {
+        bench_free(t->concurrent, live[i]);
+    }
+
+    return NULL;
+}
+
+// Returns nanoseconds per step over all threads, each step is one alloc and one free
+static double bench_run(Bench_Thread *threads, size_t thread_count, bool concurrent) {
+    double start, end;
+
+    if(concurrent) {
+        concurrent_buddy_init(&bench_concurrent, bench_buffer, BENCH_BUFFER_SIZE, DEFAULT_ALIGNMENT);
+    } else {
+        buddy_block_init(&bench_sequential, bench_buffer, BENCH_BUFFER_SIZE, DEFAULT_ALIGNMENT);
+    }
+
+    start = bench_now();
+    for(size_t i = 0; i < thread_count; i++) {
+        threads[i].concurrent = concurrent;
+        threads[i].seed = 0x9e3779b97f4a7c15ull + i;
+        pthread_create(&threads[i].thread, NULL, bench_thread, &threads[i]);
+    }
+    for(size_t i = 0; i < thread_count; i++) {
+        pthread_join(threads[i].thread, NULL);
+    }
+    end = bench_now();
+
+    if(concurrent) {
+        concurrent_buddy_destroy(&bench_concurrent);
+    }
+
+    return (end - start) / (double)(thread_count * BENCH_STEPS);
+}
+
+int main(int argc, char **argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cores > 0? (size_t)cores : 1;
+    Bench_Thread *threads;
+
+    if(argc > 1) {
+        max_threads = (size_t)strtoul(argv[1], NULL, 10);
+        if(max_threads == 0) {
+            max_threads = 1;
+        }
+    }
+
+    threads = (Bench_Thread *)malloc(max_threads * sizeof(Bench_Thread));
+    assert(threads != NULL);
+
+    printf("%ld online cores\n", cores);
+    printf("%8s %14s %14s\n", "threads", "mutex buddy ns", "concurrent ns");
+    for(size_t count = 1; ; count *= 2) {
+        double sequential_ns, concurrent_ns;
+
+        // A core count that is not a power of two is measured as well
+        if(count > max_threads) {
+            count = max_threads;
+        }
+
+        sequential_ns = bench_run(threads, count, false);
+        concurrent_ns = bench_run(threads, count, true);
+        printf("%8zu %14.1f %14.1f\n", count, sequential_ns, concurrent_ns);
+
+        if(count == max_threads) {
+            break;
+        }
+    }
+
+    free(threads);
+    return 0;
+}
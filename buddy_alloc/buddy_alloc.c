@@ -1,27 +1,25 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "buddy_alloc.h"
 
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
 
 Buddy_Block *buddy_block_next(Buddy_Block *block) {
     return (Buddy_Block *)((char *)block + block->size);
 }
 
-size_t align_forward_size(size_t ptr, size_t align) {
-    size_t a, p, modulo;
-
-    assert(is_power_of_two((uintptr_t)align));
-
-    a = align;
-    p = ptr;
-    modulo = p & (a-1);
-
-    if(modulo != 0) {
-        p += a - modulo;
-    }
+// Blocks can only merge with their real buddy. The trees are laid out largest first, so every tree
+// starts at a multiple of its own size and the offset from head decides which side a block is on.
+bool buddy_block_is_mergeable(Buddy_Block *head, Buddy_Block *tail, Buddy_Block *block, Buddy_Block *buddy) {
+    size_t offset = (size_t)((char *)block - (char *)head);
 
-    return p;
+    return block->size == buddy->size &&
+           (offset & ((block->size << 1) - 1)) == 0 &&
+           (char *)buddy + buddy->size <= (char *)tail;
 }
 
 size_t buddy_block_size_required(Buddy_Allocator *b, size_t size) {
@@ -47,9 +45,10 @@ Buddy_Block *buddy_block_find_best(Buddy_Block *head, Buddy_Block *tail, size_t
     }
 
     while(block < tail && buddy < tail) {
-        if(block->is_free && buddy->is_free && block->size == buddy->size) {
+        if(block->is_free && buddy->is_free && buddy_block_is_mergeable(head, tail, block, buddy)) {
             // This part is an optimization that reduces fragmentation, otherwise it is not needed
             block->size <<= 1;
+            block->purged = block->purged && buddy->purged;
 
             if(size <= block->size && (best_block == NULL || block->size <= best_block->size)) {
                 best_block = block;
@@ -104,22 +103,15 @@ void buddy_block_coalescence(Buddy_Block *head, Buddy_Block *tail) {
         bool no_coalescence = true;
 
         while(block < tail && buddy < tail) {
-            if(buddy->is_free && block->size == buddy->size) {
+            if(block->is_free && buddy->is_free && buddy_block_is_mergeable(head, tail, block, buddy)) {
+                // Stay on the merged block, it might merge again with its new buddy
                 block->size <<= 1;
-                block = buddy_block_next(block);
-                if(block < tail) {
-                    buddy = buddy_block_next(block);
-                    no_coalescence = false;
-                }
-            } else if(block->size < buddy->size) {
-                block = buddy;
-                buddy = buddy_block_next(buddy);
+                block->purged = block->purged && buddy->purged;
+                no_coalescence = false;
             } else {
-                buddy = buddy_block_next(buddy);
-                if(block < tail) {
-                    buddy = buddy_block_next(block);
-                }
+                block = buddy;
             }
+            buddy = buddy_block_next(block);
         }
 
         if(no_coalescence) {
@@ -129,8 +121,9 @@ void buddy_block_coalescence(Buddy_Block *head, Buddy_Block *tail) {
 }
 
 void buddy_block_init(Buddy_Allocator *b, void *data, size_t size, size_t alignment) {
+    Buddy_Block *block;
+
     assert(data != NULL);
-    assert(is_power_of_two(size) && "size is not power-of-two");
     assert(is_power_of_two(alignment) && "alignment is not power-of-two");
 
     // The minimum alignment depends on the size of the Buddy_block header
@@ -140,23 +133,48 @@ void buddy_block_init(Buddy_Allocator *b, void *data, size_t size, size_t alignm
     }
     assert((uintptr_t)data % alignment == 0 && "data is not aligned to minimum alignment");
 
+    // A size that is not a power-of-two is split into one buddy tree per set bit, largest first,
+    // e.g. 3 GiB becomes a 2 GiB and a 1 GiB tree. Anything below the alignment is left unused.
+    size &= ~(alignment - 1);
+    assert(size != 0 && "size is smaller than the alignment");
+
     b->head = (Buddy_Block *)data;
-    b->head->size = size;
-    b->head->is_free = true;
+    block = b->head;
 
-    b->tail = buddy_block_next(b->head);
+    for(size_t i = BUDDY_TREE_COUNT; i-- > 0;) {
+        size_t bit = (size_t)1 << i;
+
+        b->tree_free[i] = 0;
+        if(bit >= alignment && (size & bit)) {
+            block->size = bit;
+            block->is_free = true;
+            block->purged = false;
+            block = buddy_block_next(block);
+            b->tree_free[i] = bit;
+        }
+    }
+
+    b->tail = block;
 
     b->alignment = alignment;
+
+    b->purge_threshold = 0;
+    b->purge_interval_ns = 0;
+    b->purge_dirty = 0;
+    b->purge_last_ns = 0;
 }
 
 Buddy_Block *buddy_block_split(Buddy_Block *block, size_t size) {
     if(block != NULL && size != 0) {
         while(size < block->size) {
             size_t sz = block->size >> 1;
+            bool purged = block->purged;
             block->size = sz;
             block = buddy_block_next(block);
             block->size = sz;
             block->is_free = true;
+            // Only the header page of the right half is written, the pages a purge hands back stay untouched
+            block->purged = purged;
         }
 
         if(size <= block->size) {
@@ -167,15 +185,52 @@ Buddy_Block *buddy_block_split(Buddy_Block *block, size_t size) {
     return NULL;
 }
 
+// The trees are laid out largest first, so the first bit where the offset of a block and the total size differ is
+// the bit of the tree it lies in
+size_t buddy_allocator_tree_index(Buddy_Allocator *b, Buddy_Block *block) {
+    size_t offset = (size_t)((char *)block - (char *)b->head);
+    size_t total = (size_t)((char *)b->tail - (char *)b->head);
+
+    return (size_t)(63 - __builtin_clzll((unsigned long long)(offset ^ total)));
+}
+
+// Only trees with enough free bytes are scanned, smallest first, so the large trees stay in one piece the longest
+Buddy_Block *buddy_allocator_find(Buddy_Allocator *b, size_t size, bool coalesce) {
+    size_t total = (size_t)((char *)b->tail - (char *)b->head);
+
+    for(size_t i = (size_t)__builtin_ctzll((unsigned long long)size); i < BUDDY_TREE_COUNT; i++) {
+        Buddy_Block *head, *tail, *found;
+
+        if(b->tree_free[i] < size) {
+            continue;
+        }
+
+        // A tree starts after all larger trees and ends where the smaller ones start
+        head = (Buddy_Block *)((char *)b->head + (total & ~((((size_t)1 << i) << 1) - 1)));
+        tail = (Buddy_Block *)((char *)b->head + (total & ~(((size_t)1 << i) - 1)));
+
+        if(coalesce) {
+            buddy_block_coalescence(head, tail);
+        }
+
+        found = buddy_block_find_best(head, tail, size);
+        if(found != NULL) {
+            b->tree_free[i] -= found->size;
+            return found;
+        }
+    }
+
+    return NULL;
+}
+
 void *buddy_allocator_alloc(Buddy_Allocator *b, size_t size) {
     if(size != 0) {
         size_t actual_size = buddy_block_size_required(b, size);
 
-        Buddy_Block *found = buddy_block_find_best(b->head, b->tail, actual_size);
+        Buddy_Block *found = buddy_allocator_find(b, actual_size, false);
         if(found == NULL) {
             //coalesce free block and search again
-            buddy_block_coalescence(b->head, b->tail);
-            found = buddy_block_find_best(b->head, b->tail, actual_size);
+            found = buddy_allocator_find(b, actual_size, true);
         }
 
         if(found != NULL) {
@@ -195,8 +250,142 @@ void buddy_allocator_free(Buddy_Allocator *b, void *data) {
 
         block = (Buddy_Block *)((char *)data - b->alignment);
         block->is_free = true;
+        block->purged = false;
+        b->tree_free[buddy_allocator_tree_index(b, block)] += block->size;
 
         //could also coalescence here
         //buddy_block_coalescence(b->head, b->tail);
+
+        b->purge_dirty += block->size;
+        if(b->purge_threshold != 0 && b->purge_dirty >= b->purge_threshold &&
+            buddy_allocator_now_ns() - b->purge_last_ns >= b->purge_interval_ns) {
+            buddy_allocator_purge(b);
+        }
+    }
+}
+
+// True if [start, end) is made only of free blocks, which is the case for a free buddy that is still split
+bool buddy_block_range_is_free(Buddy_Block *start, Buddy_Block *end) {
+    for(Buddy_Block *block = start; block < end; block = buddy_block_next(block)) {
+        if(!block->is_free) {
+            return false;
+        }
     }
+
+    return true;
+}
+
+void *buddy_allocator_resize(Buddy_Allocator *b, void *data, size_t new_size) {
+    Buddy_Block *block;
+    size_t actual_size, size, offset;
+    void *new_data;
+
+    if(data == NULL) {
+        return buddy_allocator_alloc(b, new_size);
+    }
+
+    if(new_size == 0) {
+        buddy_allocator_free(b, data);
+        return NULL;
+    }
+
+    assert((void *)b->head <= data);
+    assert(data < (void *)b->tail);
+
+    block = (Buddy_Block *)((char *)data - b->alignment);
+    actual_size = buddy_block_size_required(b, new_size);
+
+    if(actual_size <= block->size) {
+        b->tree_free[buddy_allocator_tree_index(b, block)] += block->size - actual_size;
+
+        // Shrink by splitting, the upper halves are handed back as free buddies
+        while(actual_size < block->size) {
+            Buddy_Block *buddy;
+
+            block->size >>= 1;
+            buddy = buddy_block_next(block);
+            buddy->size = block->size;
+            buddy->is_free = true;
+            buddy->purged = false;
+        }
+        return data;
+    }
+
+    // Grow in place only if every level up to the new size has a free right buddy, the block is left untouched otherwise
+    size = block->size;
+    offset = (size_t)((char *)block - (char *)b->head);
+    while(size < actual_size) {
+        Buddy_Block *buddy = (Buddy_Block *)((char *)block + size);
+        Buddy_Block *end = (Buddy_Block *)((char *)block + (size << 1));
+
+        // Same rule as buddy_block_is_mergeable, the block has to be the left buddy and stay within its tree
+        if((offset & ((size << 1) - 1)) != 0 || end > b->tail || !buddy_block_range_is_free(buddy, end)) {
+            break;
+        }
+        size <<= 1;
+    }
+
+    if(size >= actual_size) {
+        b->tree_free[buddy_allocator_tree_index(b, block)] -= size - block->size;
+        block->size = size;
+        return data;
+    }
+
+    new_data = buddy_allocator_alloc(b, new_size);
+    if(new_data == NULL) {
+        return NULL;
+    }
+
+    memcpy(new_data, data, block->size - b->alignment);
+    buddy_allocator_free(b, data);
+
+    return new_data;
+}
+
+uint64_t buddy_allocator_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void buddy_allocator_set_purge(Buddy_Allocator *b, size_t threshold, uint64_t interval_ns) {
+    b->purge_threshold = threshold;
+    b->purge_interval_ns = interval_ns;
+}
+
+size_t buddy_allocator_purge(Buddy_Allocator *b) {
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    size_t purged = 0;
+
+    buddy_block_coalescence(b->head, b->tail);
+
+    for(Buddy_Block *block = b->head; block < b->tail; block = buddy_block_next(block)) {
+        uintptr_t start, end;
+
+        // Nothing has touched the pages of a purged block since, so only blocks freed or merged after it are visited
+        if(!block->is_free || block->purged) {
+            continue;
+        }
+        block->purged = true;
+
+        // Only whole pages past the header are handed back, so the block list stays walkable
+        start = ((uintptr_t)block + sizeof(Buddy_Block) + page_size - 1) & ~(page_size - 1);
+        end = ((uintptr_t)block + block->size) & ~(page_size - 1);
+
+        if(start < end) {
+#ifdef MADV_FREE
+            if(madvise((void *)start, end - start, MADV_FREE) != 0)
+#endif
+            {
+                madvise((void *)start, end - start, MADV_DONTNEED);
+            }
+            purged += (size_t)(end - start);
+        }
+    }
+
+    b->purge_dirty = 0;
+    b->purge_last_ns = buddy_allocator_now_ns();
+
+    return purged;
 }
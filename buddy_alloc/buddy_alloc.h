@@ -1,3 +1,6 @@
+#ifndef BUDDY_ALLOC_H
+#define BUDDY_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,14 +26,26 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+// One buddy tree per set bit of the backing size
+#define BUDDY_TREE_COUNT (sizeof(size_t)*8)
+
 typedef struct Buddy_Block Buddy_Block;
 struct Buddy_Block {
     size_t size;
     bool is_free;
+    // Set once the pages of a free block went back to the OS, cleared when it is freed or merged with a block that may
+    // still be resident
+    bool purged;
 };
 
 typedef struct Buddy_Allocator Buddy_Allocator;
@@ -38,16 +53,40 @@ struct Buddy_Allocator {
     Buddy_Block *head;
     Buddy_Block *tail;
     size_t alignment;
+
+    // Free bytes of every tree, indexed by the bit of its size. Splits and merges keep it, so it only changes on alloc,
+    // free and resize, and a tree without enough free bytes is never scanned.
+    size_t tree_free[BUDDY_TREE_COUNT];
+
+    // Freed bytes since the last purge, a purge runs once they reach the threshold
+    // and the interval has passed. A threshold of 0 only purges on request.
+    size_t purge_threshold;
+    uint64_t purge_interval_ns;
+    size_t purge_dirty;
+    uint64_t purge_last_ns;
 };
 
-bool is_power_of_two(uintptr_t x);
-size_t align_forward_size(size_t ptr, size_t align);
 size_t buddy_block_size_required(Buddy_Allocator *b, size_t size);
 Buddy_Block *buddy_block_next(Buddy_Block *block);
+bool buddy_block_is_mergeable(Buddy_Block *head, Buddy_Block *tail, Buddy_Block *block, Buddy_Block *buddy);
 
 Buddy_Block *buddy_block_find_best(Buddy_Block *head, Buddy_Block *tail, size_t size);
 Buddy_Block *buddy_block_split(Buddy_Block *block, size_t size);
+size_t buddy_allocator_tree_index(Buddy_Allocator *b, Buddy_Block *block);
+Buddy_Block *buddy_allocator_find(Buddy_Allocator *b, size_t size, bool coalesce);
 void *buddy_allocator_alloc(Buddy_Allocator *b, size_t size);
 void buddy_allocator_free(Buddy_Allocator *b, void *data);
+bool buddy_block_range_is_free(Buddy_Block *start, Buddy_Block *end);
+void *buddy_allocator_resize(Buddy_Allocator *b, void *data, size_t new_size);
 void buddy_block_coalescence(Buddy_Block *head, Buddy_Block *tail);
 void buddy_block_init(Buddy_Allocator *b, void *data, size_t size, size_t alignment);
+
+uint64_t buddy_allocator_now_ns(void);
+void buddy_allocator_set_purge(Buddy_Allocator *b, size_t threshold, uint64_t interval_ns);
+size_t buddy_allocator_purge(Buddy_Allocator *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
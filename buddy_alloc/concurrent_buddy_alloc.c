@@ -0,0 +1,202 @@
+#include "concurrent_buddy_alloc.h"
+
+size_t concurrent_buddy_order(Concurrent_Buddy *b, size_t block_size) {
+    size_t order = 0;
+
+    while((b->min_block_size << order) < block_size) {
+        order++;
+    }
+
+    return order;
+}
+
+// Both procedures expect the order lock to be held
+void concurrent_buddy_push(Concurrent_Buddy_Order *order, Concurrent_Buddy_Block *block, size_t block_size) {
+    block->prev = NULL;
+    block->next = order->head;
+    if(order->head != NULL) {
+        order->head->prev = block;
+    }
+    order->head = block;
+
+    atomic_store_explicit(&block->state, block_size | CONCURRENT_BUDDY_FREE, memory_order_release);
+}
+
+void concurrent_buddy_remove(Concurrent_Buddy_Order *order, Concurrent_Buddy_Block *block) {
+    if(block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        order->head = block->next;
+    }
+
+    if(block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+}
+
+void concurrent_buddy_init(Concurrent_Buddy *b, void *data, size_t size, size_t alignment) {
+    unsigned char *root;
+
+    assert(data != NULL);
+    assert(is_power_of_two(alignment) && "alignment is not power-of-two");
+
+    // The header in front of the data only holds the state, the links of a free block may use the rest
+    if(alignment < sizeof(size_t)) {
+        alignment = sizeof(size_t);
+    }
+    assert((uintptr_t)data % alignment == 0 && "data is not aligned to minimum alignment");
+
+    b->data = (unsigned char *)data;
+    b->alignment = alignment;
+
+    b->min_block_size = alignment << 1;
+    while(b->min_block_size < sizeof(Concurrent_Buddy_Block)) {
+        b->min_block_size <<= 1;
+    }
+
+    // Like buddy_block_init, a size that is not a power-of-two becomes one tree per set bit, largest first
+    size &= ~(b->min_block_size - 1);
+    assert(size != 0 && "size is smaller than the minimum block");
+    b->size = size;
+
+    b->order_count = 0;
+    while((b->min_block_size << b->order_count) <= (size >> 1)) {
+        b->order_count++;
+    }
+    b->order_count++;
+    assert(b->order_count <= CONCURRENT_BUDDY_MAX_ORDERS);
+
+    for(size_t i = 0; i < b->order_count; i++) {
+        pthread_mutex_init(&b->orders[i].lock, NULL);
+        b->orders[i].head = NULL;
+    }
+
+    // Each tree root goes on the list of its own order, so allocation stays one list lookup per order
+    root = b->data;
+    for(size_t i = b->order_count; i-- > 0;) {
+        size_t root_size = b->min_block_size << i;
+
+        if(size & root_size) {
+            concurrent_buddy_push(&b->orders[i], (Concurrent_Buddy_Block *)root, root_size);
+            root += root_size;
+        }
+    }
+}
+
+void concurrent_buddy_destroy(Concurrent_Buddy *b) {
+    for(size_t i = 0; i < b->order_count; i++) {
+        pthread_mutex_destroy(&b->orders[i].lock);
+    }
+    b->order_count = 0;
+}
+
+void *concurrent_buddy_alloc(Concurrent_Buddy *b, size_t size) {
+    Concurrent_Buddy_Block *block = NULL;
+    size_t wanted, order;
+
+    if(size == 0 || size > b->size - b->alignment) {
+        return NULL;
+    }
+
+    wanted = concurrent_buddy_order(b, size + b->alignment);
+    if(wanted >= b->order_count) {
+        return NULL;
+    }
+
+    // Only one order lock is ever held at a time, so there is no lock ordering to respect.
+    // A block that is being merged by a concurrent free is on no list for a moment, so this
+    // can fail spuriously when the allocator is almost full.
+    for(order = wanted; order < b->order_count; order++) {
+        Concurrent_Buddy_Order *o = &b->orders[order];
+
+        pthread_mutex_lock(&o->lock);
+        block = o->head;
+        if(block != NULL) {
+            concurrent_buddy_remove(o, block);
+            atomic_store_explicit(&block->state, b->min_block_size << order, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&o->lock);
+
+        if(block != NULL) {
+            break;
+        }
+    }
+
+    if(block == NULL) {
+        return NULL;
+    }
+
+    // Split down to the wanted order, handing the right halves to their free lists
+    while(order > wanted) {
+        size_t half_size;
+        Concurrent_Buddy_Block *half;
+
+        order--;
+        half_size = b->min_block_size << order;
+        half = (Concurrent_Buddy_Block *)((char *)block + half_size);
+
+        atomic_store_explicit(&block->state, half_size, memory_order_relaxed);
+
+        pthread_mutex_lock(&b->orders[order].lock);
+        concurrent_buddy_push(&b->orders[order], half, half_size);
+        pthread_mutex_unlock(&b->orders[order].lock);
+    }
+
+    return (void *)((char *)block + b->alignment);
+}
+
+void concurrent_buddy_free(Concurrent_Buddy *b, void *data) {
+    Concurrent_Buddy_Block *block;
+    size_t block_size, order;
+
+    if(data == NULL) {
+        return;
+    }
+
+    assert((void *)b->data <= data);
+    assert(data < (void *)(b->data + b->size));
+
+    block = (Concurrent_Buddy_Block *)((char *)data - b->alignment);
+    block_size = atomic_load_explicit(&block->state, memory_order_relaxed);
+    assert((block_size & CONCURRENT_BUDDY_FREE) == 0 && "Double free in buddy allocator");
+    order = concurrent_buddy_order(b, block_size);
+
+    while(true) {
+        Concurrent_Buddy_Order *o = &b->orders[order];
+        Concurrent_Buddy_Block *buddy;
+        size_t offset = (size_t)((unsigned char *)block - b->data);
+
+        // Tree roots have no buddy, their would-be buddy lies past the end of the region
+        if(order + 1 == b->order_count || (offset ^ block_size) + block_size > b->size) {
+            pthread_mutex_lock(&o->lock);
+            concurrent_buddy_push(o, block, block_size);
+            pthread_mutex_unlock(&o->lock);
+            return;
+        }
+
+        buddy = (Concurrent_Buddy_Block *)(b->data + (offset ^ block_size));
+
+        // A buddy only carries the free bit with this exact size while it is on this order's
+        // list, and that can only change under this lock, so the check and the removal are atomic.
+        pthread_mutex_lock(&o->lock);
+        if(atomic_load_explicit(&buddy->state, memory_order_acquire) != (block_size | CONCURRENT_BUDDY_FREE)) {
+            concurrent_buddy_push(o, block, block_size);
+            pthread_mutex_unlock(&o->lock);
+            return;
+        }
+        concurrent_buddy_remove(o, buddy);
+        pthread_mutex_unlock(&o->lock);
+
+        // Clear the header that ends up inside the merged block
+        if(buddy < block) {
+            atomic_store_explicit(&block->state, 0, memory_order_relaxed);
+            block = buddy;
+        } else {
+            atomic_store_explicit(&buddy->state, 0, memory_order_relaxed);
+        }
+
+        block_size <<= 1;
+        order++;
+        atomic_store_explicit(&block->state, block_size, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef CONCURRENT_BUDDY_ALLOC_H
+#define CONCURRENT_BUDDY_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DEFAULT_ALIGNMENT
+#define DEFAULT_ALIGNMENT (2*sizeof(void *))
+#endif
+
+#ifndef CONCURRENT_BUDDY_MAX_ORDERS
+#define CONCURRENT_BUDDY_MAX_ORDERS 48
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+// The lowest bit of the state marks a block that sits on the free list of its order,
+// block sizes are at least the alignment so the bit is never part of the size.
+#define CONCURRENT_BUDDY_FREE ((size_t)1)
+
+typedef struct Concurrent_Buddy_Block Concurrent_Buddy_Block;
+
+// The C++ side only ever sees pointers to blocks, the layout uses C atomics
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+struct Concurrent_Buddy_Block {
+    _Atomic size_t state;
+    // The links are only valid while the block is free, they overlap the user data otherwise
+    Concurrent_Buddy_Block *prev;
+    Concurrent_Buddy_Block *next;
+};
+#endif
+
+typedef struct Concurrent_Buddy_Order Concurrent_Buddy_Order;
+struct Concurrent_Buddy_Order {
+    ALIGN_AS(CACHE_LINE_SIZE) pthread_mutex_t lock;
+    Concurrent_Buddy_Block *head;
+};
+
+typedef struct Concurrent_Buddy Concurrent_Buddy;
+struct Concurrent_Buddy {
+    unsigned char *data;
+    size_t size;
+    size_t alignment;
+    size_t min_block_size;
+    size_t order_count;
+
+    Concurrent_Buddy_Order orders[CONCURRENT_BUDDY_MAX_ORDERS];
+};
+
+size_t concurrent_buddy_order(Concurrent_Buddy *b, size_t block_size);
+void concurrent_buddy_push(Concurrent_Buddy_Order *order, Concurrent_Buddy_Block *block, size_t block_size);
+void concurrent_buddy_remove(Concurrent_Buddy_Order *order, Concurrent_Buddy_Block *block);
+
+void concurrent_buddy_init(Concurrent_Buddy *b, void *data, size_t size, size_t alignment);
+void concurrent_buddy_destroy(Concurrent_Buddy *b);
+void *concurrent_buddy_alloc(Concurrent_Buddy *b, size_t size);
+void concurrent_buddy_free(Concurrent_Buddy *b, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef COMPOSE_H
+#define COMPOSE_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "../lin_alloc/lin_alloc.h"
+#include "../stack_alloc/stack_alloc.h"
+#include "../pool_alloc/pool_alloc.h"
+#include "../list_alloc/list_alloc.h"
+#include "../buddy_alloc/buddy_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A composable allocator is a type T with these three functions, the names are built with token pasting so they
+// carry the type name as it is:
+//
+//     void *compose_T_alloc(T *a, size_t size);
+//     void compose_T_free(T *a, void *ptr, size_t size);
+//     bool compose_T_owns(T *a, void *ptr);
+//
+// alloc returns NULL when it cannot serve the request, so a composite can try another allocator. free gets the size
+// that was requested, which lets a composite pick the owner without asking. The macros below generate new composable
+// types out of existing ones, everything is static inline so the whole tree inlines into the caller and the owner of
+// a free is found with plain comparisons, no function pointers.
+
+#define COMPOSE_ALLOC(T, a, size) compose_##T##_alloc((a), (size))
+#define COMPOSE_FREE(T, a, ptr, size) compose_##T##_free((a), (ptr), (size))
+#define COMPOSE_OWNS(T, a, ptr) compose_##T##_owns((a), (ptr))
+
+// Base allocators
+
+static inline void *compose_Arena_alloc(Arena *a, size_t size) {
+    return arena_alloc(a, size);
+}
+
+// An arena only frees everything at once
+static inline void compose_Arena_free(Arena *a, void *ptr, size_t size) {
+    (void)a;
+    (void)ptr;
+    (void)size;
+}
+
+static inline bool compose_Arena_owns(Arena *a, void *ptr) {
+    return (void *)a->buf <= ptr && ptr < (void *)(a->buf + a->buf_len);
+}
+
+static inline void *compose_Stack_alloc(Stack *s, size_t size) {
+    return stack_alloc(s, size);
+}
+
+static inline void compose_Stack_free(Stack *s, void *ptr, size_t size) {
+    (void)size;
+    stack_free(s, ptr);
+}
+
+static inline bool compose_Stack_owns(Stack *s, void *ptr) {
+    return (void *)s->buf <= ptr && ptr < (void *)(s->buf + s->buf_len);
+}
+
+static inline void *compose_Pool_alloc(Pool *p, size_t size) {
+    // pool_alloc asserts on an empty pool, a composite wants NULL instead
+    if(size > p->chunk_size || p->head == NULL) {
+        return NULL;
+    }
+    return pool_alloc(p);
+}
+
+static inline void compose_Pool_free(Pool *p, void *ptr, size_t size) {
+    (void)size;
+    pool_free(p, ptr);
+}
+
+static inline bool compose_Pool_owns(Pool *p, void *ptr) {
+    return (void *)p->buf <= ptr && ptr < (void *)(p->buf + p->buf_len);
+}
+
+static inline void *compose_Free_List_alloc(Free_List *fl, size_t size) {
+#ifndef NDEBUG
+    // free_list_alloc asserts when no block fits. Every policy finds a block exactly when first-fit does, so first-fit
+    // answers the question for all of them. Release builds skip this, there free_list_alloc returns NULL on its own.
+    size_t required = size < sizeof(Free_List_Node)? sizeof(Free_List_Node) : size;
+    required = align_forward_size(required, sizeof(void *));
+    if(free_list_find_first(fl, required, DEFAULT_ALIGNMENT, NULL, NULL) == NULL) {
+        return NULL;
+    }
+#endif
+    return free_list_alloc(fl, size, DEFAULT_ALIGNMENT);
+}
+
+static inline void compose_Free_List_free(Free_List *fl, void *ptr, size_t size) {
+    (void)size;
+    free_list_free(fl, ptr);
+}
+
+static inline bool compose_Free_List_owns(Free_List *fl, void *ptr) {
+    return fl->data <= ptr && ptr < (void *)((char *)fl->data + fl->size);
+}
+
+static inline void *compose_Buddy_Allocator_alloc(Buddy_Allocator *b, size_t size) {
+    return buddy_allocator_alloc(b, size);
+}
+
+static inline void compose_Buddy_Allocator_free(Buddy_Allocator *b, void *ptr, size_t size) {
+    (void)size;
+    buddy_allocator_free(b, ptr);
+}
+
+static inline bool compose_Buddy_Allocator_owns(Buddy_Allocator *b, void *ptr) {
+    return (void *)b->head <= ptr && ptr < (void *)b->tail;
+}
+
+// Composites
+
+// Sizes up to threshold go to small, larger ones to large. Both the alloc and the free side decide on the size alone.
+#define COMPOSE_SEGREGATOR(Name, threshold, Small, Large)                                   \
+    typedef struct Name Name;                                                               \
+    struct Name {                                                                           \
+        Small small;                                                                        \
+        Large large;                                                                        \
+    };                                                                                      \
+                                                                                            \
+    static inline void *compose_##Name##_alloc(Name *a, size_t size) {                      \
+        if(size <= (threshold)) {                                                           \
+            return compose_##Small##_alloc(&a->small, size);                                \
+        }                                                                                   \
+        return compose_##Large##_alloc(&a->large, size);                                    \
+    }                                                                                       \
+                                                                                            \
+    static inline void compose_##Name##_free(Name *a, void *ptr, size_t size) {             \
+        if(size <= (threshold)) {                                                           \
+            compose_##Small##_free(&a->small, ptr, size);                                   \
+        } else {                                                                            \
+            compose_##Large##_free(&a->large, ptr, size);                                   \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline bool compose_##Name##_owns(Name *a, void *ptr) {                         \
+        return compose_##Small##_owns(&a->small, ptr) || compose_##Large##_owns(&a->large, ptr); \
+    }
+
+// Tries primary first and secondary when primary returns NULL. A free goes back to whichever of the two owns it.
+#define COMPOSE_FALLBACK(Name, Primary, Secondary)                                          \
+    typedef struct Name Name;                                                               \
+    struct Name {                                                                           \
+        Primary primary;                                                                    \
+        Secondary secondary;                                                                \
+    };                                                                                      \
+                                                                                            \
+    static inline void *compose_##Name##_alloc(Name *a, size_t size) {                      \
+        void *ptr = compose_##Primary##_alloc(&a->primary, size);                           \
+        if(ptr == NULL) {                                                                   \
+            ptr = compose_##Secondary##_alloc(&a->secondary, size);                         \
+        }                                                                                   \
+        return ptr;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    static inline void compose_##Name##_free(Name *a, void *ptr, size_t size) {             \
+        if(compose_##Primary##_owns(&a->primary, ptr)) {                                    \
+            compose_##Primary##_free(&a->primary, ptr, size);                               \
+        } else {                                                                            \
+            compose_##Secondary##_free(&a->secondary, ptr, size);                           \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline bool compose_##Name##_owns(Name *a, void *ptr) {                         \
+        return compose_##Primary##_owns(&a->primary, ptr) ||                                \
+               compose_##Secondary##_owns(&a->secondary, ptr);                              \
+    }
+
+// One allocator per step sized bucket, bucket i serves sizes in (min + i*step, min + (i+1)*step]. Sizes outside of
+// (min, max] return NULL, so a bucketizer is usually the small side of a segregator. Each bucket has to be initialized
+// by hand, compose_Name_bucket_size gives the largest size it will see, which is the chunk size for a Pool.
+#define COMPOSE_BUCKETIZER(Name, Alloc, min, max, step)                                     \
+    enum { Name##_BUCKET_COUNT = ((max) - (min)) / (step) };                                \
+                                                                                            \
+    typedef struct Name Name;                                                               \
+    struct Name {                                                                           \
+        Alloc buckets[Name##_BUCKET_COUNT];                                                 \
+    };                                                                                      \
+                                                                                            \
+    static inline size_t compose_##Name##_bucket_size(size_t i) {                           \
+        return (size_t)(min) + (i + 1) * (size_t)(step);                                    \
+    }                                                                                       \
+                                                                                            \
+    static inline void *compose_##Name##_alloc(Name *a, size_t size) {                      \
+        if(size <= (size_t)(min) || size > (size_t)(max)) {                                 \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return compose_##Alloc##_alloc(&a->buckets[(size - (min) - 1) / (step)], size);     \
+    }                                                                                       \
+                                                                                            \
+    static inline void compose_##Name##_free(Name *a, void *ptr, size_t size) {             \
+        if(ptr == NULL) {                                                                   \
+            return;                                                                         \
+        }                                                                                   \
+        assert(size > (size_t)(min) && size <= (size_t)(max) && "Size is not served by this bucketizer"); \
+        compose_##Alloc##_free(&a->buckets[(size - (min) - 1) / (step)], ptr, size);        \
+    }                                                                                       \
+                                                                                            \
+    static inline bool compose_##Name##_owns(Name *a, void *ptr) {                         \
+        for(size_t i = 0; i < Name##_BUCKET_COUNT; i++) {                                   \
+            if(compose_##Alloc##_owns(&a->buckets[i], ptr)) {                               \
+                return true;                                                                \
+            }                                                                               \
+        }                                                                                   \
+        return false;                                                                       \
+    }
+
+// Counts the calls and bytes that go through to parent, it changes nothing about the allocations themselves
+#define COMPOSE_STATS_COLLECTOR(Name, Alloc)                                                \
+    typedef struct Name Name;                                                               \
+    struct Name {                                                                           \
+        Alloc parent;                                                                       \
+                                                                                            \
+        size_t alloc_count;                                                                 \
+        size_t free_count;                                                                  \
+        size_t fail_count;                                                                  \
+        size_t bytes_allocated;                                                             \
+        size_t bytes_freed;                                                                 \
+        size_t bytes_live;                                                                  \
+        size_t bytes_high_water;                                                            \
+    };                                                                                      \
+                                                                                            \
+    static inline void *compose_##Name##_alloc(Name *a, size_t size) {                      \
+        void *ptr = compose_##Alloc##_alloc(&a->parent, size);                              \
+        if(ptr == NULL) {                                                                   \
+            a->fail_count++;                                                                \
+            return NULL;                                                                    \
+        }                                                                                   \
+        a->alloc_count++;                                                                   \
+        a->bytes_allocated += size;                                                         \
+        a->bytes_live += size;                                                              \
+        if(a->bytes_live > a->bytes_high_water) {                                           \
+            a->bytes_high_water = a->bytes_live;                                            \
+        }                                                                                   \
+        return ptr;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    static inline void compose_##Name##_free(Name *a, void *ptr, size_t size) {             \
+        if(ptr == NULL) {                                                                   \
+            return;                                                                         \
+        }                                                                                   \
+        compose_##Alloc##_free(&a->parent, ptr, size);                                      \
+        a->free_count++;                                                                    \
+        a->bytes_freed += size;                                                             \
+        a->bytes_live -= size;                                                              \
+    }                                                                                       \
+                                                                                            \
+    static inline bool compose_##Name##_owns(Name *a, void *ptr) {                         \
+        return compose_##Alloc##_owns(&a->parent, ptr);                                     \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef CORE_ALIGN_H
+#define CORE_ALIGN_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Every allocator shares these, they are static inline so any number of allocators can be linked into one binary
+// and the fast paths inline into their callers. The macros work in constant expressions.
+#define IS_POWER_OF_TWO(x) ((((x) & ((x) - 1)) == 0))
+#define ALIGN_FORWARD(x, a) (((x) + ((a) - 1)) & ~((a) - 1))
+#define ALIGN_BACKWARD(x, a) ((x) & ~((a) - 1))
+
+// C++ has no _Alignof and _Alignas, macros in the headers that take a type or an alignment use these instead
+#ifdef __cplusplus
+#define ALIGN_OF(T) alignof(T)
+#define ALIGN_AS(a) alignas(a)
+#else
+#define ALIGN_OF(T) _Alignof(T)
+#define ALIGN_AS(a) _Alignas(a)
+#endif
+
+static inline bool is_power_of_two(uintptr_t x) {
+    return IS_POWER_OF_TWO(x);
+}
+
+static inline uintptr_t align_forward(uintptr_t ptr, size_t align) {
+    assert(is_power_of_two((uintptr_t)align));
+
+    return ALIGN_FORWARD(ptr, (uintptr_t)align);
+}
+
+static inline uintptr_t align_forward_uinptr(uintptr_t ptr, uintptr_t align) {
+    assert(is_power_of_two(align));
+
+    return ALIGN_FORWARD(ptr, align);
+}
+
+static inline size_t align_forward_size(size_t ptr, size_t align) {
+    assert(is_power_of_two((uintptr_t)align));
+
+    return ALIGN_FORWARD(ptr, align);
+}
+
+static inline uintptr_t align_backward(uintptr_t ptr, size_t align) {
+    assert(is_power_of_two((uintptr_t)align));
+
+    return ALIGN_BACKWARD(ptr, (uintptr_t)align);
+}
+
+// The smallest padding of at least header_size that aligns ptr + padding, without branches or divisions
+static inline size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size) {
+    assert(is_power_of_two(alignment));
+
+    return (size_t)(ALIGN_FORWARD(ptr + (uintptr_t)header_size, alignment) - ptr);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
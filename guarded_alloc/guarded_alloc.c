@@ -0,0 +1,291 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "guarded_alloc.h"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// The fault handler has no way to receive a pointer, so it reports on the installed instance
+static Guarded_Alloc *guarded_handler_instance;
+static struct sigaction guarded_previous_action;
+
+uint64_t guarded_next_random(Guarded_Alloc *ga) {
+    uint64_t x = ga->rng;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    ga->rng = x;
+
+    return x;
+}
+
+unsigned char *guarded_slot_start(Guarded_Alloc *ga, size_t index) {
+    return ga->region + ga->page_size + index * (ga->slot_size + ga->page_size);
+}
+
+bool guarded_init(Guarded_Alloc *ga, size_t slot_count, size_t slot_size, size_t sample_rate) {
+    void *region;
+    void *frames[1];
+
+    assert(slot_count != 0);
+
+    ga->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    ga->slot_size = (slot_size + ga->page_size - 1) & ~(ga->page_size - 1);
+    if(ga->slot_size == 0) {
+        ga->slot_size = ga->page_size;
+    }
+    ga->slot_count = slot_count;
+    ga->region_len = ga->page_size + slot_count * (ga->slot_size + ga->page_size);
+
+    // Everything starts inaccessible, slots are opened only while they hold an allocation
+    region = mmap(NULL, ga->region_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+        return false;
+    }
+
+    ga->slots = (Guarded_Slot *)calloc(slot_count, sizeof(Guarded_Slot));
+    if(ga->slots == NULL) {
+        munmap(region, ga->region_len);
+        return false;
+    }
+
+    ga->region = (unsigned char *)region;
+    ga->next_slot = 0;
+    ga->sample_rate = sample_rate;
+    ga->rng = (uint64_t)(uintptr_t)region ^ 0x9e3779b97f4a7c15ull;
+    ga->countdown = 1;
+    if(sample_rate != 0) {
+        ga->countdown = 1 + guarded_next_random(ga) % (2 * sample_rate - 1);
+    }
+
+    // The first backtrace() may allocate while loading the unwinder, do it now rather than in a sampled path
+    backtrace(frames, 1);
+
+    return true;
+}
+
+void guarded_destroy(Guarded_Alloc *ga) {
+    if(guarded_handler_instance == ga) {
+        sigaction(SIGSEGV, &guarded_previous_action, NULL);
+        guarded_handler_instance = NULL;
+    }
+
+    munmap(ga->region, ga->region_len);
+    free(ga->slots);
+    ga->region = NULL;
+    ga->slots = NULL;
+}
+
+bool guarded_should_sample(Guarded_Alloc *ga) {
+    if(ga == NULL || ga->sample_rate == 0) {
+        return false;
+    }
+
+    if(--ga->countdown != 0) {
+        return false;
+    }
+
+    // Random intervals with a mean of sample_rate, so a fixed allocation pattern can't always dodge the sample
+    ga->countdown = 1 + guarded_next_random(ga) % (2 * ga->sample_rate - 1);
+    return true;
+}
+
+bool guarded_owns(Guarded_Alloc *ga, void *ptr) {
+    return ga != NULL && (void *)ga->region <= ptr && ptr < (void *)(ga->region + ga->region_len);
+}
+
+void *guarded_alloc(Guarded_Alloc *ga, size_t size, size_t alignment) {
+    Guarded_Slot *slot = NULL;
+    unsigned char *start;
+    uintptr_t ptr;
+    size_t index = 0;
+
+    assert(is_power_of_two(alignment));
+
+    if(size == 0 || size > ga->slot_size) {
+        return NULL;
+    }
+
+    // Round robin keeps freed slots protected for as long as possible before they are reused
+    for(size_t i = 0; i < ga->slot_count; i++) {
+        index = (ga->next_slot + i) % ga->slot_count;
+        if(ga->slots[index].state != Guarded_Slot_Allocated) {
+            slot = &ga->slots[index];
+            break;
+        }
+    }
+
+    if(slot == NULL) {
+        return NULL;
+    }
+
+    start = guarded_slot_start(ga, index);
+
+    // The object ends against the right guard page, alignment may leave a few bytes of slack
+    ptr = ((uintptr_t)start + ga->slot_size - size) & ~((uintptr_t)alignment - 1);
+    if(ptr < (uintptr_t)start) {
+        return NULL;
+    }
+
+    if(mprotect(start, ga->slot_size, PROT_READ | PROT_WRITE) != 0) {
+        return NULL;
+    }
+
+    ga->next_slot = (index + 1) % ga->slot_count;
+
+    slot->state = Guarded_Slot_Allocated;
+    slot->ptr = ptr;
+    slot->size = size;
+    slot->alloc_depth = backtrace(slot->alloc_stack, GUARDED_STACK_DEPTH);
+    slot->free_depth = 0;
+
+    return memset((void *)ptr, 0, size);
+}
+
+void guarded_print_stack(const char *title, void **stack, int depth) {
+    if(depth > 0) {
+        dprintf(STDERR_FILENO, "%s:\n", title);
+        backtrace_symbols_fd(stack, depth, STDERR_FILENO);
+    }
+}
+
+void guarded_report(Guarded_Alloc *ga, const char *what, uintptr_t addr, size_t index) {
+    Guarded_Slot *slot = &ga->slots[index];
+
+    dprintf(STDERR_FILENO, "Guarded allocator: %s at 0x%lx, %zu byte allocation at 0x%lx\n",
+            what, (unsigned long)addr, slot->size, (unsigned long)slot->ptr);
+    guarded_print_stack("Allocated by", slot->alloc_stack, slot->alloc_depth);
+    guarded_print_stack("Freed by", slot->free_stack, slot->free_depth);
+}
+
+void guarded_free(Guarded_Alloc *ga, void *ptr) {
+    uintptr_t offset;
+    size_t stride, index;
+    Guarded_Slot *slot;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    assert(guarded_owns(ga, ptr));
+
+    stride = ga->slot_size + ga->page_size;
+    offset = (uintptr_t)ptr - (uintptr_t)ga->region - ga->page_size;
+    index = (size_t)(offset / stride);
+    slot = &ga->slots[index < ga->slot_count? index : ga->slot_count - 1];
+
+    if(slot->state == Guarded_Slot_Freed && slot->ptr == (uintptr_t)ptr) {
+        guarded_report(ga, "double free", (uintptr_t)ptr, (size_t)(slot - ga->slots));
+        abort();
+    }
+
+    if(slot->state != Guarded_Slot_Allocated || slot->ptr != (uintptr_t)ptr) {
+        dprintf(STDERR_FILENO, "Guarded allocator: invalid free of 0x%lx\n", (unsigned long)(uintptr_t)ptr);
+        abort();
+    }
+
+    slot->state = Guarded_Slot_Freed;
+    slot->free_depth = backtrace(slot->free_stack, GUARDED_STACK_DEPTH);
+
+    // Stays inaccessible until the slot is recycled, so a use-after-free faults
+    mprotect(guarded_slot_start(ga, (size_t)(slot - ga->slots)), ga->slot_size, PROT_NONE);
+}
+
+static void guarded_fault_handler(int sig, siginfo_t *info, void *context) {
+    Guarded_Alloc *ga = guarded_handler_instance;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+
+    (void)context;
+
+    if(guarded_owns(ga, (void *)addr)) {
+        size_t stride = ga->slot_size + ga->page_size;
+        uintptr_t offset = addr - (uintptr_t)ga->region;
+        size_t index = (size_t)(offset / stride);
+
+        if(offset % stride >= ga->page_size) {
+            // Inside a slot, it is only protected while freed
+            guarded_report(ga, "use after free", addr, index);
+        } else {
+            // Inside a guard page, blame whichever neighbouring object is closer
+            Guarded_Slot *left = index > 0? &ga->slots[index - 1] : NULL;
+            Guarded_Slot *right = index < ga->slot_count? &ga->slots[index] : NULL;
+            uintptr_t left_dist = ~(uintptr_t)0, right_dist = ~(uintptr_t)0;
+
+            if(left != NULL && left->state != Guarded_Slot_Empty) {
+                left_dist = addr - (left->ptr + left->size);
+            }
+            if(right != NULL && right->state != Guarded_Slot_Empty) {
+                right_dist = right->ptr - addr;
+            }
+
+            if(left_dist <= right_dist && left_dist != ~(uintptr_t)0) {
+                guarded_report(ga, "buffer overflow", addr, index - 1);
+            } else if(right_dist != ~(uintptr_t)0) {
+                guarded_report(ga, "buffer underflow", addr, index);
+            } else {
+                dprintf(STDERR_FILENO, "Guarded allocator: wild access at 0x%lx\n", (unsigned long)addr);
+            }
+        }
+    }
+
+    // Returning with the previous action restored faults again and lets it crash the usual way
+    sigaction(sig, &guarded_previous_action, NULL);
+}
+
+bool guarded_install_handler(Guarded_Alloc *ga) {
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = guarded_fault_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+
+    guarded_handler_instance = ga;
+    return sigaction(SIGSEGV, &action, &guarded_previous_action) == 0;
+}
+
+void *guarded_free_list_alloc(Guarded_Alloc *ga, Free_List *fl, size_t size, size_t alignment) {
+    if(guarded_should_sample(ga)) {
+        void *ptr = guarded_alloc(ga, size, alignment);
+        if(ptr != NULL) {
+            return ptr;
+        }
+    }
+
+    return free_list_alloc(fl, size, alignment);
+}
+
+void guarded_free_list_free(Guarded_Alloc *ga, Free_List *fl, void *ptr) {
+    if(guarded_owns(ga, ptr)) {
+        guarded_free(ga, ptr);
+    } else {
+        free_list_free(fl, ptr);
+    }
+}
+
+void *guarded_pool_alloc(Guarded_Alloc *ga, Pool *p) {
+    if(guarded_should_sample(ga)) {
+        // The chunk size is already aligned to the chunk alignment, so this keeps it aligned as well
+        size_t alignment = p->chunk_size & (~p->chunk_size + 1);
+        void *ptr = guarded_alloc(ga, p->chunk_size, alignment);
+        if(ptr != NULL) {
+            return ptr;
+        }
+    }
+
+    return pool_alloc(p);
+}
+
+void guarded_pool_free(Guarded_Alloc *ga, Pool *p, void *ptr) {
+    if(guarded_owns(ga, ptr)) {
+        guarded_free(ga, ptr);
+    } else {
+        pool_free(p, ptr);
+    }
+}
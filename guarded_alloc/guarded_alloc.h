@@ -0,0 +1,100 @@
+#ifndef GUARDED_ALLOC_H
+#define GUARDED_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "../list_alloc/list_alloc.h"
+#include "../pool_alloc/pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GUARDED_STACK_DEPTH
+#define GUARDED_STACK_DEPTH 32
+#endif
+
+enum Guarded_Slot_State {
+    Guarded_Slot_Empty,
+    Guarded_Slot_Allocated,
+    Guarded_Slot_Freed
+};
+typedef enum Guarded_Slot_State Guarded_Slot_State;
+
+typedef struct Guarded_Slot Guarded_Slot;
+struct Guarded_Slot {
+    Guarded_Slot_State state;
+    uintptr_t ptr;
+    size_t size;
+
+    int alloc_depth;
+    int free_depth;
+    void *alloc_stack[GUARDED_STACK_DEPTH];
+    void *free_stack[GUARDED_STACK_DEPTH];
+};
+
+// Every slot sits between two PROT_NONE guard pages: [guard][slot 0][guard][slot 1]...[guard]
+typedef struct Guarded_Alloc Guarded_Alloc;
+struct Guarded_Alloc {
+    unsigned char *region;
+    size_t region_len;
+    size_t page_size;
+    size_t slot_size;
+    size_t slot_count;
+    size_t next_slot;
+
+    Guarded_Slot *slots;
+
+    // On average one allocation in sample_rate is guarded, 0 disables sampling
+    size_t sample_rate;
+    size_t countdown;
+    uint64_t rng;
+};
+
+uint64_t guarded_next_random(Guarded_Alloc *ga);
+unsigned char *guarded_slot_start(Guarded_Alloc *ga, size_t index);
+void guarded_print_stack(const char *title, void **stack, int depth);
+void guarded_report(Guarded_Alloc *ga, const char *what, uintptr_t addr, size_t index);
+
+bool guarded_init(Guarded_Alloc *ga, size_t slot_count, size_t slot_size, size_t sample_rate);
+void guarded_destroy(Guarded_Alloc *ga);
+bool guarded_install_handler(Guarded_Alloc *ga);
+
+bool guarded_should_sample(Guarded_Alloc *ga);
+bool guarded_owns(Guarded_Alloc *ga, void *ptr);
+void *guarded_alloc(Guarded_Alloc *ga, size_t size, size_t alignment);
+void guarded_free(Guarded_Alloc *ga, void *ptr);
+
+void *guarded_free_list_alloc(Guarded_Alloc *ga, Free_List *fl, size_t size, size_t alignment);
+void guarded_free_list_free(Guarded_Alloc *ga, Free_List *fl, void *ptr);
+void *guarded_pool_alloc(Guarded_Alloc *ga, Pool *p);
+void guarded_pool_free(Guarded_Alloc *ga, Pool *p, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,519 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "heap_prof.h"
+
+#include <execinfo.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+
+// Frames of heap_prof_sample and heap_prof_record_alloc, they are the same in every stack
+#define HEAP_PROF_SKIP_FRAMES 2
+
+// Set from the signal handler, the dump itself happens on the next sample or heap_prof_poll
+static volatile sig_atomic_t heap_prof_dump_requested;
+
+static void heap_prof_signal_handler(int sig) {
+    (void)sig;
+    heap_prof_dump_requested = 1;
+}
+
+size_t heap_prof_round_up_pow2(size_t x) {
+    size_t p = 1;
+
+    while(p < x) {
+        p <<= 1;
+    }
+
+    return p;
+}
+
+int64_t heap_prof_next_interval(Heap_Prof *hp) {
+    uint64_t x = hp->rng;
+    double u;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    hp->rng = x;
+
+    // Exponentially distributed gaps make the sampled bytes a Poisson process, so every byte
+    // has the same chance of being sampled no matter how the allocations are sized
+    u = (double)((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (int64_t)(-log(u) * (double)hp->period) + 1;
+}
+
+bool heap_prof_init(Heap_Prof *hp, size_t period, size_t max_stacks, size_t max_objects) {
+    hp->period = period != 0? period : HEAP_PROF_DEFAULT_PERIOD;
+    hp->rng = (uint64_t)(uintptr_t)hp ^ (uint64_t)time(NULL) ^ 0x9e3779b97f4a7c15ull;
+    if(hp->rng == 0) {
+        hp->rng = 1;
+    }
+    hp->bytes_until_sample = heap_prof_next_interval(hp);
+
+    // Tables are kept at most 3/4 full so probe sequences stay short
+    hp->stack_capacity = heap_prof_round_up_pow2(max_stacks + max_stacks / 3 + 1);
+    hp->stack_count = 0;
+    hp->object_capacity = heap_prof_round_up_pow2(max_objects + max_objects / 3 + 1);
+    hp->object_count = 0;
+    hp->signal_path = NULL;
+
+    hp->stacks = (Heap_Prof_Stack *)calloc(hp->stack_capacity, sizeof(Heap_Prof_Stack));
+    hp->objects = (Heap_Prof_Object *)calloc(hp->object_capacity, sizeof(Heap_Prof_Object));
+
+    if(hp->stacks == NULL || hp->objects == NULL) {
+        heap_prof_destroy(hp);
+        return false;
+    }
+
+    // backtrace() may allocate the first time it is called, keep that out of the sampled path
+    {
+        void *frames[1];
+        backtrace(frames, 1);
+    }
+
+    return true;
+}
+
+void heap_prof_destroy(Heap_Prof *hp) {
+    free(hp->stacks);
+    free(hp->objects);
+    hp->stacks = NULL;
+    hp->objects = NULL;
+    hp->stack_count = 0;
+    hp->object_count = 0;
+}
+
+size_t heap_prof_object_slot(Heap_Prof *hp, uintptr_t ptr) {
+    return (size_t)(((uint64_t)ptr >> 4) * 0x9e3779b97f4a7c15ull >> 20) & (hp->object_capacity - 1);
+}
+
+void heap_prof_object_remove(Heap_Prof *hp, size_t i) {
+    size_t mask = hp->object_capacity - 1;
+    size_t j = i;
+
+    hp->object_count--;
+
+    // Backward shift deletion, so lookups never need tombstones
+    while(true) {
+        size_t home;
+
+        hp->objects[i].ptr = 0;
+
+        while(true) {
+            j = (j + 1) & mask;
+            if(hp->objects[j].ptr == 0) {
+                return;
+            }
+            home = heap_prof_object_slot(hp, hp->objects[j].ptr);
+            // Move j into the hole unless its home lies cyclically in (i, j]
+            if(i <= j? (i < home && home <= j) : (i < home || home <= j)) {
+                continue;
+            }
+            break;
+        }
+
+        hp->objects[i] = hp->objects[j];
+        i = j;
+    }
+}
+
+void heap_prof_sample(Heap_Prof *hp, void *ptr, size_t size) {
+    void *frames[HEAP_PROF_STACK_DEPTH + HEAP_PROF_SKIP_FRAMES];
+    int depth, skip;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t mask, i;
+    Heap_Prof_Stack *stack = NULL;
+    double weight;
+
+    hp->bytes_until_sample = heap_prof_next_interval(hp);
+
+    depth = backtrace(frames, HEAP_PROF_STACK_DEPTH + HEAP_PROF_SKIP_FRAMES);
+    skip = depth > HEAP_PROF_SKIP_FRAMES? HEAP_PROF_SKIP_FRAMES : 0;
+    depth -= skip;
+
+    for(int f = 0; f < depth; f++) {
+        hash = (hash ^ (uint64_t)(uintptr_t)frames[skip + f]) * 0x100000001b3ull;
+    }
+
+    mask = hp->stack_capacity - 1;
+    for(i = (size_t)hash & mask; hp->stacks[i].depth != 0; i = (i + 1) & mask) {
+        if(hp->stacks[i].hash == hash && hp->stacks[i].depth == depth &&
+            memcmp(hp->stacks[i].frames, &frames[skip], (size_t)depth * sizeof(void *)) == 0) {
+            stack = &hp->stacks[i];
+            break;
+        }
+    }
+
+    if(stack == NULL) {
+        if((hp->stack_count + 1) * 4 > hp->stack_capacity * 3) {
+            // Out of room for new call sites, the sample is dropped
+            return;
+        }
+        stack = &hp->stacks[i];
+        stack->hash = hash;
+        stack->depth = depth;
+        memcpy(stack->frames, &frames[skip], (size_t)depth * sizeof(void *));
+        hp->stack_count++;
+    }
+
+    // Probability that an allocation of this size was sampled is 1 - e^(-size/period)
+    weight = 1.0 / (1.0 - exp(-(double)size / (double)hp->period));
+
+    stack->alloc_objects += weight;
+    stack->alloc_bytes += weight * (double)size;
+
+    if((hp->object_count + 1) * 4 <= hp->object_capacity * 3) {
+        mask = hp->object_capacity - 1;
+        for(i = heap_prof_object_slot(hp, (uintptr_t)ptr); hp->objects[i].ptr != 0; i = (i + 1) & mask) {
+        }
+
+        hp->objects[i].ptr = (uintptr_t)ptr;
+        hp->objects[i].size = size;
+        hp->objects[i].stack = (size_t)(stack - hp->stacks);
+        hp->objects[i].weight = weight;
+        hp->object_count++;
+
+        stack->live_objects += weight;
+        stack->live_bytes += weight * (double)size;
+    }
+
+    heap_prof_poll(hp);
+}
+
+void heap_prof_record_alloc(Heap_Prof *hp, void *ptr, size_t size) {
+    if(ptr == NULL) {
+        return;
+    }
+
+    hp->bytes_until_sample -= (int64_t)size;
+    if(hp->bytes_until_sample > 0) {
+        return;
+    }
+
+    heap_prof_sample(hp, ptr, size);
+}
+
+void heap_prof_object_release(Heap_Prof *hp, size_t i) {
+    Heap_Prof_Object *object = &hp->objects[i];
+    Heap_Prof_Stack *stack = &hp->stacks[object->stack];
+
+    stack->live_objects -= object->weight;
+    stack->live_bytes -= object->weight * (double)object->size;
+
+    heap_prof_object_remove(hp, i);
+}
+
+void heap_prof_record_free(Heap_Prof *hp, void *ptr) {
+    size_t mask, i;
+
+    if(ptr == NULL || hp->object_count == 0) {
+        return;
+    }
+
+    mask = hp->object_capacity - 1;
+    for(i = heap_prof_object_slot(hp, (uintptr_t)ptr); hp->objects[i].ptr != 0; i = (i + 1) & mask) {
+        if(hp->objects[i].ptr == (uintptr_t)ptr) {
+            heap_prof_object_release(hp, i);
+            return;
+        }
+    }
+}
+
+void heap_prof_record_free_range(Heap_Prof *hp, void *start, size_t len) {
+    uintptr_t begin = (uintptr_t)start;
+    uintptr_t end = begin + (uintptr_t)len;
+
+    for(size_t i = 0; i < hp->object_capacity && hp->object_count != 0; i++) {
+        // Removal can shift another object into this slot, so look at it again
+        while(hp->objects[i].ptr != 0 && begin <= hp->objects[i].ptr && hp->objects[i].ptr < end) {
+            heap_prof_object_release(hp, i);
+        }
+    }
+}
+
+void heap_prof_buffer_reserve(Heap_Prof_Buffer *buf, size_t extra) {
+    if(buf->len + extra > buf->cap) {
+        size_t cap = buf->cap != 0? buf->cap : 4096;
+        unsigned char *data;
+
+        while(cap < buf->len + extra) {
+            cap <<= 1;
+        }
+
+        data = (unsigned char *)realloc(buf->data, cap);
+        assert(data != NULL && "Out of memory while encoding the profile");
+        buf->data = data;
+        buf->cap = cap;
+    }
+}
+
+void heap_prof_buffer_varint(Heap_Prof_Buffer *buf, uint64_t value) {
+    heap_prof_buffer_reserve(buf, 10);
+
+    while(value >= 0x80) {
+        buf->data[buf->len++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buf->data[buf->len++] = (unsigned char)value;
+}
+
+void heap_prof_buffer_int(Heap_Prof_Buffer *buf, uint32_t field, uint64_t value) {
+    heap_prof_buffer_varint(buf, (uint64_t)field << 3);
+    heap_prof_buffer_varint(buf, value);
+}
+
+void heap_prof_buffer_bytes(Heap_Prof_Buffer *buf, uint32_t field, const void *data, size_t len) {
+    heap_prof_buffer_varint(buf, ((uint64_t)field << 3) | 2);
+    heap_prof_buffer_varint(buf, (uint64_t)len);
+    heap_prof_buffer_reserve(buf, len);
+    memcpy(&buf->data[buf->len], data, len);
+    buf->len += len;
+}
+
+int heap_prof_compare_address(const void *a, const void *b) {
+    uintptr_t x = *(const uintptr_t *)a;
+    uintptr_t y = *(const uintptr_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+uint64_t heap_prof_estimate(double value) {
+    return value > 0.0? (uint64_t)(value + 0.5) : 0;
+}
+
+// Encodes a profile.proto message (github.com/google/pprof/proto/profile.proto) in the same
+// shape as a Go heap profile, so `pprof -sample_index=alloc_space` picks the cumulative view.
+bool heap_prof_encode(Heap_Prof *hp, Heap_Prof_Buffer *out) {
+    enum {
+        STR_EMPTY, STR_ALLOC_OBJECTS, STR_COUNT, STR_ALLOC_SPACE, STR_BYTES,
+        STR_INUSE_OBJECTS, STR_INUSE_SPACE, STR_SPACE, STR_FIXED_COUNT
+    };
+    static const char *fixed_strings[STR_FIXED_COUNT] = {
+        "", "alloc_objects", "count", "alloc_space", "bytes", "inuse_objects", "inuse_space", "space"
+    };
+    static const uint64_t sample_types[4][2] = {
+        { STR_ALLOC_OBJECTS, STR_COUNT }, { STR_ALLOC_SPACE, STR_BYTES },
+        { STR_INUSE_OBJECTS, STR_COUNT }, { STR_INUSE_SPACE, STR_BYTES }
+    };
+
+    Heap_Prof_Buffer msg = {0};
+    Heap_Prof_Buffer packed = {0};
+    uintptr_t *addresses;
+    uint64_t *mapping_ids;
+    size_t address_count = 0;
+    size_t mapping_count = 0;
+    struct timespec now;
+    char line[4096];
+    FILE *maps;
+
+    for(size_t i = 0; i < STR_FIXED_COUNT; i++) {
+        heap_prof_buffer_bytes(out, 6, fixed_strings[i], strlen(fixed_strings[i]));
+    }
+
+    for(size_t i = 0; i < 4; i++) {
+        msg.len = 0;
+        heap_prof_buffer_int(&msg, 1, sample_types[i][0]);
+        heap_prof_buffer_int(&msg, 2, sample_types[i][1]);
+        heap_prof_buffer_bytes(out, 1, msg.data, msg.len);
+    }
+
+    // Every distinct frame becomes one location, ids are positions in the sorted array
+    addresses = (uintptr_t *)malloc((hp->stack_count * HEAP_PROF_STACK_DEPTH + 1) * sizeof(uintptr_t));
+    if(addresses == NULL) {
+        return false;
+    }
+
+    for(size_t i = 0; i < hp->stack_capacity; i++) {
+        for(int f = 0; f < hp->stacks[i].depth; f++) {
+            // Return addresses point after the call, step back into it for the right line
+            addresses[address_count++] = (uintptr_t)hp->stacks[i].frames[f] - 1;
+        }
+    }
+
+    qsort(addresses, address_count, sizeof(uintptr_t), heap_prof_compare_address);
+    if(address_count != 0) {
+        size_t unique = 1;
+        for(size_t i = 1; i < address_count; i++) {
+            if(addresses[i] != addresses[unique - 1]) {
+                addresses[unique++] = addresses[i];
+            }
+        }
+        address_count = unique;
+    }
+
+    mapping_ids = (uint64_t *)calloc(address_count + 1, sizeof(uint64_t));
+    if(mapping_ids == NULL) {
+        free(addresses);
+        return false;
+    }
+
+    for(size_t i = 0; i < hp->stack_capacity; i++) {
+        Heap_Prof_Stack *stack = &hp->stacks[i];
+
+        if(stack->depth == 0) {
+            continue;
+        }
+
+        msg.len = 0;
+
+        packed.len = 0;
+        for(int f = 0; f < stack->depth; f++) {
+            uintptr_t address = (uintptr_t)stack->frames[f] - 1;
+            uintptr_t *found = (uintptr_t *)bsearch(&address, addresses, address_count, sizeof(uintptr_t), heap_prof_compare_address);
+            heap_prof_buffer_varint(&packed, (uint64_t)(found - addresses) + 1);
+        }
+        heap_prof_buffer_bytes(&msg, 1, packed.data, packed.len);
+
+        packed.len = 0;
+        heap_prof_buffer_varint(&packed, heap_prof_estimate(stack->alloc_objects));
+        heap_prof_buffer_varint(&packed, heap_prof_estimate(stack->alloc_bytes));
+        heap_prof_buffer_varint(&packed, heap_prof_estimate(stack->live_objects));
+        heap_prof_buffer_varint(&packed, heap_prof_estimate(stack->live_bytes));
+        heap_prof_buffer_bytes(&msg, 2, packed.data, packed.len);
+
+        heap_prof_buffer_bytes(out, 2, msg.data, msg.len);
+    }
+
+    // Executable mappings let pprof symbolize the addresses against the binaries
+    maps = fopen("/proc/self/maps", "r");
+    if(maps != NULL) {
+        size_t string_index = STR_FIXED_COUNT;
+
+        while(fgets(line, sizeof(line), maps) != NULL) {
+            unsigned long start, limit, offset;
+            char perms[5];
+            int path_start = 0;
+            char *path;
+
+            if(sscanf(line, "%lx-%lx %4s %lx %*s %*s %n", &start, &limit, perms, &offset, &path_start) < 4 ||
+                perms[2] != 'x' || path_start == 0 || line[path_start] != '/') {
+                continue;
+            }
+
+            path = &line[path_start];
+            path[strcspn(path, "\n")] = '\0';
+            heap_prof_buffer_bytes(out, 6, path, strlen(path));
+
+            mapping_count++;
+            msg.len = 0;
+            heap_prof_buffer_int(&msg, 1, mapping_count);
+            heap_prof_buffer_int(&msg, 2, start);
+            heap_prof_buffer_int(&msg, 3, limit);
+            heap_prof_buffer_int(&msg, 4, offset);
+            heap_prof_buffer_int(&msg, 5, string_index++);
+            heap_prof_buffer_bytes(out, 3, msg.data, msg.len);
+
+            for(size_t i = 0; i < address_count; i++) {
+                if(start <= addresses[i] && addresses[i] < limit) {
+                    mapping_ids[i] = mapping_count;
+                }
+            }
+        }
+        fclose(maps);
+    }
+
+    // Addresses outside any file mapping still need a location, they just stay unsymbolized
+    for(size_t i = 0; i < address_count; i++) {
+        msg.len = 0;
+        heap_prof_buffer_int(&msg, 1, i + 1);
+        if(mapping_ids[i] != 0) {
+            heap_prof_buffer_int(&msg, 2, mapping_ids[i]);
+        }
+        heap_prof_buffer_int(&msg, 3, addresses[i]);
+        heap_prof_buffer_bytes(out, 4, msg.data, msg.len);
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    heap_prof_buffer_int(out, 9, (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec);
+
+    msg.len = 0;
+    heap_prof_buffer_int(&msg, 1, STR_SPACE);
+    heap_prof_buffer_int(&msg, 2, STR_BYTES);
+    heap_prof_buffer_bytes(out, 11, msg.data, msg.len);
+    heap_prof_buffer_int(out, 12, hp->period);
+    heap_prof_buffer_int(out, 14, STR_INUSE_SPACE);
+
+    free(addresses);
+    free(mapping_ids);
+    free(msg.data);
+    free(packed.data);
+
+    return true;
+}
+
+bool heap_prof_write(Heap_Prof *hp, const char *path) {
+    Heap_Prof_Buffer out = {0};
+    bool ok = false;
+    FILE *f;
+
+    if(!heap_prof_encode(hp, &out)) {
+        free(out.data);
+        return false;
+    }
+
+    f = fopen(path, "wb");
+    if(f != NULL) {
+        ok = fwrite(out.data, 1, out.len, f) == out.len;
+        ok = fclose(f) == 0 && ok;
+    }
+
+    free(out.data);
+    return ok;
+}
+
+bool heap_prof_install_signal(Heap_Prof *hp, int signo, const char *path) {
+    struct sigaction action;
+
+    hp->signal_path = path;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = heap_prof_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    return sigaction(signo, &action, NULL) == 0;
+}
+
+void heap_prof_poll(Heap_Prof *hp) {
+    if(heap_prof_dump_requested && hp->signal_path != NULL) {
+        heap_prof_dump_requested = 0;
+        heap_prof_write(hp, hp->signal_path);
+    }
+}
+
+void *heap_prof_arena_alloc(Heap_Prof *hp, Arena *a, size_t size) {
+    void *ptr = arena_alloc(a, size);
+    heap_prof_record_alloc(hp, ptr, size);
+    return ptr;
+}
+
+void heap_prof_arena_free_all(Heap_Prof *hp, Arena *a) {
+    heap_prof_record_free_range(hp, a->buf, a->buf_len);
+    arena_free_all(a);
+}
+
+void *heap_prof_pool_alloc(Heap_Prof *hp, Pool *p) {
+    void *ptr = pool_alloc(p);
+    heap_prof_record_alloc(hp, ptr, p->chunk_size);
+    return ptr;
+}
+
+void heap_prof_pool_free(Heap_Prof *hp, Pool *p, void *ptr) {
+    heap_prof_record_free(hp, ptr);
+    pool_free(p, ptr);
+}
+
+void *heap_prof_free_list_alloc(Heap_Prof *hp, Free_List *fl, size_t size, size_t alignment) {
+    void *ptr = free_list_alloc(fl, size, alignment);
+    heap_prof_record_alloc(hp, ptr, size);
+    return ptr;
+}
+
+void heap_prof_free_list_free(Heap_Prof *hp, Free_List *fl, void *ptr) {
+    heap_prof_record_free(hp, ptr);
+    free_list_free(fl, ptr);
+}
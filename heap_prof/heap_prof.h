@@ -0,0 +1,129 @@
+#ifndef HEAP_PROF_H
+#define HEAP_PROF_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "../lin_alloc/lin_alloc.h"
+#include "../list_alloc/list_alloc.h"
+#include "../pool_alloc/pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef HEAP_PROF_STACK_DEPTH
+#define HEAP_PROF_STACK_DEPTH 32
+#endif
+
+// Same default as tcmalloc, one sample per 512 KiB allocated on average
+#ifndef HEAP_PROF_DEFAULT_PERIOD
+#define HEAP_PROF_DEFAULT_PERIOD (512*1024)
+#endif
+
+typedef struct Heap_Prof_Stack Heap_Prof_Stack;
+struct Heap_Prof_Stack {
+    uint64_t hash;
+    int depth;
+    void *frames[HEAP_PROF_STACK_DEPTH];
+
+    // Unbiased estimates, every sample stands for all the allocations it was drawn from
+    double alloc_objects;
+    double alloc_bytes;
+    double live_objects;
+    double live_bytes;
+};
+
+typedef struct Heap_Prof_Object Heap_Prof_Object;
+struct Heap_Prof_Object {
+    uintptr_t ptr;
+    size_t size;
+    size_t stack;
+    double weight;
+};
+
+typedef struct Heap_Prof Heap_Prof;
+struct Heap_Prof {
+    size_t period;
+    int64_t bytes_until_sample;
+    uint64_t rng;
+
+    // Both tables use open addressing, their capacities are powers-of-two
+    Heap_Prof_Stack *stacks;
+    size_t stack_capacity;
+    size_t stack_count;
+
+    Heap_Prof_Object *objects;
+    size_t object_capacity;
+    size_t object_count;
+
+    const char *signal_path;
+};
+
+typedef struct Heap_Prof_Buffer Heap_Prof_Buffer;
+struct Heap_Prof_Buffer {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+};
+
+size_t heap_prof_round_up_pow2(size_t x);
+int64_t heap_prof_next_interval(Heap_Prof *hp);
+size_t heap_prof_object_slot(Heap_Prof *hp, uintptr_t ptr);
+void heap_prof_object_remove(Heap_Prof *hp, size_t i);
+void heap_prof_object_release(Heap_Prof *hp, size_t i);
+int heap_prof_compare_address(const void *a, const void *b);
+uint64_t heap_prof_estimate(double value);
+
+bool heap_prof_init(Heap_Prof *hp, size_t period, size_t max_stacks, size_t max_objects);
+void heap_prof_destroy(Heap_Prof *hp);
+
+void heap_prof_record_alloc(Heap_Prof *hp, void *ptr, size_t size);
+void heap_prof_record_free(Heap_Prof *hp, void *ptr);
+void heap_prof_record_free_range(Heap_Prof *hp, void *start, size_t len);
+void heap_prof_sample(Heap_Prof *hp, void *ptr, size_t size);
+
+bool heap_prof_write(Heap_Prof *hp, const char *path);
+bool heap_prof_install_signal(Heap_Prof *hp, int signo, const char *path);
+void heap_prof_poll(Heap_Prof *hp);
+
+void heap_prof_buffer_reserve(Heap_Prof_Buffer *buf, size_t extra);
+void heap_prof_buffer_varint(Heap_Prof_Buffer *buf, uint64_t value);
+void heap_prof_buffer_int(Heap_Prof_Buffer *buf, uint32_t field, uint64_t value);
+void heap_prof_buffer_bytes(Heap_Prof_Buffer *buf, uint32_t field, const void *data, size_t len);
+bool heap_prof_encode(Heap_Prof *hp, Heap_Prof_Buffer *out);
+
+void *heap_prof_arena_alloc(Heap_Prof *hp, Arena *a, size_t size);
+void heap_prof_arena_free_all(Heap_Prof *hp, Arena *a);
+void *heap_prof_pool_alloc(Heap_Prof *hp, Pool *p);
+void heap_prof_pool_free(Heap_Prof *hp, Pool *p, void *ptr);
+void *heap_prof_free_list_alloc(Heap_Prof *hp, Free_List *fl, size_t size, size_t alignment);
+void heap_prof_free_list_free(Heap_Prof *hp, Free_List *fl, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+#include "arena_containers.h"
+
+#include <stdio.h>
+
+void arena_vector_init(Arena_Vector *v, Arena *a, size_t elem_size, size_t align, size_t first_capacity) {
+    assert(first_capacity != 0 && is_power_of_two(first_capacity) && "First chunk capacity must be a power of two");
+
+    v->arena = a;
+    v->elem_size = elem_size;
+    v->align = align;
+    v->first_capacity = first_capacity;
+    v->len = 0;
+    v->chunk_count = 0;
+}
+
+// Chunks 0..k-1 hold first_capacity * (2^k - 1) elements, so the chunk follows from the highest bit of the index
+size_t arena_vector_chunk_of(Arena_Vector *v, size_t index, size_t *offset) {
+    size_t q = index / v->first_capacity + 1;
+    size_t k = (size_t)(63 - __builtin_clzll((unsigned long long)q));
+
+    *offset = index - v->first_capacity * (((size_t)1 << k) - 1);
+    return k;
+}
+
+void *arena_vector_push(Arena_Vector *v) {
+    size_t offset;
+    size_t k = arena_vector_chunk_of(v, v->len, &offset);
+
+    if(k == v->chunk_count) {
+        unsigned char *chunk;
+
+        if(k == ARENA_VECTOR_MAX_CHUNKS) {
+            return NULL;
+        }
+
+        chunk = (unsigned char *)arena_alloc_array(v->arena, v->elem_size, v->first_capacity << k, v->align);
+        if(chunk == NULL) {
+            return NULL;
+        }
+        v->chunks[k] = chunk;
+        v->chunk_count++;
+    }
+
+    v->len++;
+    // Chunks come zeroed from the arena and elements are never removed, so the slot is still zero
+    return v->chunks[k] + offset * v->elem_size;
+}
+
+void *arena_vector_at(Arena_Vector *v, size_t index) {
+    size_t offset;
+    size_t k;
+
+    if(index >= v->len) {
+        assert(0 && "Arena vector index out of bounds");
+        return NULL;
+    }
+
+    k = arena_vector_chunk_of(v, index, &offset);
+    return v->chunks[k] + offset * v->elem_size;
+}
+
+bool arena_string_builder_init(Arena_String_Builder *sb, Arena *a, size_t capacity) {
+    sb->arena = a;
+    sb->len = 0;
+    sb->cap = capacity;
+    sb->data = (char *)arena_alloc_align(a, capacity + 1, 1);
+
+    return sb->data != NULL;
+}
+
+bool arena_string_builder_reserve(Arena_String_Builder *sb, size_t extra) {
+    Arena *a = sb->arena;
+    size_t offset = (size_t)((unsigned char *)sb->data - a->buf);
+    size_t needed, new_cap;
+    char *data;
+
+    if(extra > (size_t)-1 - sb->len - 1) {
+        return false;
+    }
+
+    needed = sb->len + extra;
+    if(needed <= sb->cap) {
+        return true;
+    }
+
+    // Nothing was allocated after the builder, so it just takes the space that follows
+    if(a->prev_offset == offset && needed + 1 <= a->buf_len - offset) {
+        a->curr_offset = offset + needed + 1;
+        sb->cap = needed;
+        return true;
+    }
+
+    // Otherwise it moves to the top and doubles, the old block stays behind until the arena is reset
+    new_cap = sb->cap * 2 > needed? sb->cap * 2 : needed;
+    data = (char *)arena_alloc_align(a, new_cap + 1, 1);
+    if(data == NULL) {
+        return false;
+    }
+
+    memcpy(data, sb->data, sb->len + 1);
+    sb->data = data;
+    sb->cap = new_cap;
+
+    return true;
+}
+
+bool arena_string_builder_append(Arena_String_Builder *sb, const char *str, size_t len) {
+    if(!arena_string_builder_reserve(sb, len)) {
+        return false;
+    }
+
+    memcpy(sb->data + sb->len, str, len);
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+
+    return true;
+}
+
+bool arena_string_builder_append_cstr(Arena_String_Builder *sb, const char *str) {
+    return arena_string_builder_append(sb, str, strlen(str));
+}
+
+bool arena_string_builder_appendf(Arena_String_Builder *sb, const char *fmt, ...) {
+    va_list args, args_copy;
+    int len;
+
+    va_start(args, fmt);
+    va_copy(args_copy, args);
+
+    len = vsnprintf(NULL, 0, fmt, args_copy);
+    va_end(args_copy);
+
+    if(len < 0 || !arena_string_builder_reserve(sb, (size_t)len)) {
+        va_end(args);
+        return false;
+    }
+
+    vsnprintf(sb->data + sb->len, (size_t)len + 1, fmt, args);
+    va_end(args);
+
+    sb->len += (size_t)len;
+
+    return true;
+}
+
+// Hands the unused capacity back to the arena when the builder is still the top allocation
+char *arena_string_builder_finish(Arena_String_Builder *sb) {
+    Arena *a = sb->arena;
+    size_t offset = (size_t)((unsigned char *)sb->data - a->buf);
+
+    if(a->prev_offset == offset) {
+        a->curr_offset = offset + sb->len + 1;
+        sb->cap = sb->len;
+    }
+
+    return sb->data;
+}
+
+// FNV-1a, 0 is reserved for empty slots
+uint64_t arena_hash_bytes(const void *data, size_t len) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = 14695981039346656037ull;
+
+    for(size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash == 0? 1 : hash;
+}
+
+bool arena_map_init(Arena_Map *m, Arena *a, size_t capacity) {
+    if(capacity < ARENA_MAP_MIN_CAPACITY) {
+        capacity = ARENA_MAP_MIN_CAPACITY;
+    }
+    assert(is_power_of_two(capacity) && "Arena map capacity must be a power of two");
+
+    m->arena = a;
+    m->capacity = capacity;
+    m->count = 0;
+    m->entries = (Arena_Map_Entry *)arena_alloc_array(a, sizeof(Arena_Map_Entry), capacity, _Alignof(Arena_Map_Entry));
+
+    return m->entries != NULL;
+}
+
+// Returns the entry of the key, or the empty slot where it would go
+Arena_Map_Entry *arena_map_find(Arena_Map *m, const void *key, size_t key_len, uint64_t hash) {
+    size_t mask = m->capacity - 1;
+    size_t i = (size_t)hash & mask;
+
+    while(true) {
+        Arena_Map_Entry *e = &m->entries[i];
+
+        if(e->hash == 0) {
+            return e;
+        }
+        if(e->hash == hash && e->key_len == key_len && memcmp(e->key, key, key_len) == 0) {
+            return e;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+// The old table cannot be freed on an arena, but with doubling all dead tables together are smaller than the live one
+bool arena_map_grow(Arena_Map *m) {
+    Arena_Map_Entry *old_entries = m->entries;
+    size_t old_capacity = m->capacity;
+    Arena_Map_Entry *entries;
+
+    entries = (Arena_Map_Entry *)arena_alloc_array(m->arena, sizeof(Arena_Map_Entry), old_capacity * 2,
+                                                   _Alignof(Arena_Map_Entry));
+    if(entries == NULL) {
+        return false;
+    }
+
+    m->entries = entries;
+    m->capacity = old_capacity * 2;
+
+    for(size_t i = 0; i < old_capacity; i++) {
+        if(old_entries[i].hash != 0) {
+            *arena_map_find(m, old_entries[i].key, old_entries[i].key_len, old_entries[i].hash) = old_entries[i];
+        }
+    }
+
+    return true;
+}
+
+void **arena_map_get(Arena_Map *m, const void *key, size_t key_len) {
+    Arena_Map_Entry *e = arena_map_find(m, key, key_len, arena_hash_bytes(key, key_len));
+
+    return e->hash != 0? &e->value : NULL;
+}
+
+bool arena_map_put(Arena_Map *m, const void *key, size_t key_len, void *value) {
+    uint64_t hash = arena_hash_bytes(key, key_len);
+    Arena_Map_Entry *e = arena_map_find(m, key, key_len, hash);
+
+    if(e->hash == 0) {
+        // Keeps the load factor at 3/4 at most, so probes stay short
+        if((m->count + 1) * 4 > m->capacity * 3) {
+            if(!arena_map_grow(m)) {
+                return false;
+            }
+            e = arena_map_find(m, key, key_len, hash);
+        }
+
+        e->hash = hash;
+        e->key = key;
+        e->key_len = key_len;
+        m->count++;
+    }
+    e->value = value;
+
+    return true;
+}
+
+bool arena_interner_init(Arena_Interner *in, Arena *a, size_t capacity) {
+    return arena_map_init(&in->map, a, capacity);
+}
+
+// Equal strings always give back the same pointer, so interned strings can be compared with ==
+const char *arena_intern(Arena_Interner *in, const char *str, size_t len) {
+    void **found = arena_map_get(&in->map, str, len);
+    char *copy;
+
+    if(found != NULL) {
+        return (const char *)*found;
+    }
+
+    copy = (char *)arena_alloc_align(in->map.arena, len + 1, 1);
+    if(copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    // The copy is the key as well, the caller's string can go away
+    if(!arena_map_put(&in->map, copy, len, copy)) {
+        return NULL;
+    }
+
+    return copy;
+}
+
+const char *arena_intern_cstr(Arena_Interner *in, const char *str) {
+    return arena_intern(in, str, strlen(str));
+}
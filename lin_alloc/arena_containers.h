@@ -0,0 +1,124 @@
+#ifndef ARENA_CONTAINERS_H
+#define ARENA_CONTAINERS_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <stdarg.h>
+
+#include "lin_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Chunk k of a vector holds first_capacity << k elements, so this many chunks are never running out
+#ifndef ARENA_VECTOR_MAX_CHUNKS
+#define ARENA_VECTOR_MAX_CHUNKS 48
+#endif
+
+#ifndef ARENA_MAP_MIN_CAPACITY
+#define ARENA_MAP_MIN_CAPACITY 16
+#endif
+
+typedef struct Arena_Vector Arena_Vector;
+typedef struct Arena_String_Builder Arena_String_Builder;
+typedef struct Arena_Map_Entry Arena_Map_Entry;
+typedef struct Arena_Map Arena_Map;
+typedef struct Arena_Interner Arena_Interner;
+
+// Grows by adding chunks twice the size of the previous one, elements never move once pushed
+struct Arena_Vector {
+    Arena *arena;
+    size_t elem_size;
+    size_t align;
+    size_t first_capacity;
+    size_t len;
+
+    unsigned char *chunks[ARENA_VECTOR_MAX_CHUNKS];
+    size_t chunk_count;
+};
+
+// The data stays NUL terminated, it is only moved when something else was allocated on the arena after it
+struct Arena_String_Builder {
+    Arena *arena;
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+// A hash of 0 marks an empty slot
+struct Arena_Map_Entry {
+    uint64_t hash;
+    const void *key;
+    size_t key_len;
+    void *value;
+};
+
+// Open addressing with linear probing. Keys are not copied, they have to live at least as long as the map.
+struct Arena_Map {
+    Arena *arena;
+    Arena_Map_Entry *entries;
+    size_t capacity;
+    size_t count;
+};
+
+struct Arena_Interner {
+    Arena_Map map;
+};
+
+#define arena_vector_init_type(v, a, T, first_capacity) \
+    arena_vector_init((v), (a), sizeof(T), ALIGN_OF(T), (first_capacity))
+#define arena_vector_push_type(v, T) ((T *)arena_vector_push((v)))
+#define arena_vector_at_type(v, T, i) ((T *)arena_vector_at((v), (i)))
+
+void arena_vector_init(Arena_Vector *v, Arena *a, size_t elem_size, size_t align, size_t first_capacity);
+size_t arena_vector_chunk_of(Arena_Vector *v, size_t index, size_t *offset);
+void *arena_vector_push(Arena_Vector *v);
+void *arena_vector_at(Arena_Vector *v, size_t index);
+
+bool arena_string_builder_init(Arena_String_Builder *sb, Arena *a, size_t capacity);
+bool arena_string_builder_reserve(Arena_String_Builder *sb, size_t extra);
+bool arena_string_builder_append(Arena_String_Builder *sb, const char *str, size_t len);
+bool arena_string_builder_append_cstr(Arena_String_Builder *sb, const char *str);
+bool arena_string_builder_appendf(Arena_String_Builder *sb, const char *fmt, ...);
+char *arena_string_builder_finish(Arena_String_Builder *sb);
+
+uint64_t arena_hash_bytes(const void *data, size_t len);
+bool arena_map_init(Arena_Map *m, Arena *a, size_t capacity);
+Arena_Map_Entry *arena_map_find(Arena_Map *m, const void *key, size_t key_len, uint64_t hash);
+bool arena_map_grow(Arena_Map *m);
+void **arena_map_get(Arena_Map *m, const void *key, size_t key_len);
+bool arena_map_put(Arena_Map *m, const void *key, size_t key_len, void *value);
+
+bool arena_interner_init(Arena_Interner *in, Arena *a, size_t capacity);
+const char *arena_intern(Arena_Interner *in, const char *str, size_t len);
+const char *arena_intern_cstr(Arena_Interner *in, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,44 +1,12 @@
-#include "lin-alloc.h"
-
-struct Arena {
-    unsigned char *buf;
-    size_t buf_len;
-    size_t prev_offset;
-    size_t curr_offset;
-};
-
-struct Temp_Arena_Memory {
-	Arena *arena;
-	size_t prev_offset;
-	size_t curr_offset;
-};
-
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-unsigned long align_forward(uintptr_t ptr, size_t align) {
-    uintptr_t p, a, modulo;
-
-    assert(is_power_of_two(align));
-    p = ptr;
-    a = (uintptr_t) align;
-
-    modulo = p & (a-1);
-
-    if(modulo != 0) {
-        p += a - modulo;
-    }
-
-    return p;
-}
+#include "lin_alloc.h"
 
 void *arena_alloc_align(Arena *a, size_t size, size_t align) {
     uintptr_t curr_ptr = (uintptr_t)a->buf + (uintptr_t)a->curr_offset;
     uintptr_t offset = align_forward(curr_ptr, align);
     offset -= (uintptr_t)a->buf;
 
-    if(offset+size <= a->buf_len) {
+    // A large alignment can push the offset past the end, so it is checked before the subtraction
+    if(offset <= a->buf_len && size <= a->buf_len - offset) {
         void *ptr = &a->buf[offset];
         a->prev_offset = offset;
         a->curr_offset = offset+size;
@@ -55,15 +23,18 @@ void *arena_resize_align(Arena *a, void *old_memory, size_t old_size, size_t new
     if(old_mem == NULL || old_size == 0) {
         return arena_alloc_align(a, new_size, align);
     } else if(a->buf <= old_mem && old_mem < a->buf + a->buf_len) {
-        if(a->buf + a->prev_offset == old_mem) {
+        if(a->buf + a->prev_offset == old_mem && new_size <= a->buf_len - a->prev_offset) {
             a->curr_offset = a->prev_offset + new_size;
             if(new_size > old_size) {
-                memset(&a->buf[a->curr_offset], 0, new_size - old_size);
+                memset(&a->buf[a->prev_offset + old_size], 0, new_size - old_size);
             }
             return old_memory;
         } else {
             void *new_memory = arena_alloc_align(a, new_size, align);
             size_t copy_size = old_size < new_size? old_size : new_size;
+            if(new_memory == NULL) {
+                return NULL;
+            }
             memmove(new_memory, old_memory, copy_size);
             return new_memory;
         }
@@ -78,6 +49,7 @@ void arena_init(Arena *a, void *backing_buffer, size_t backing_buffer_len) {
     a->buf_len = backing_buffer_len;
     a->curr_offset = 0;
     a->prev_offset = 0;
+    a->destructors = NULL;
 }
 
 void *arena_alloc(Arena *a, size_t size) {
@@ -89,6 +61,7 @@ void *arena_resize(Arena *a, void *old_memory, size_t old_size, size_t new_size)
 }
 
 void arena_free_all(Arena *a) {
+    arena_run_destructors(a, NULL);
     a->curr_offset = 0;
     a->prev_offset = 0;
 }
@@ -98,11 +71,109 @@ Temp_Arena_Memory temp_arena_memory(Arena *a) {
     temp.arena = a;
     temp.prev_offset = a->prev_offset;
     temp.curr_offset = a->curr_offset;
+    temp.destructors = a->destructors;
 
     return temp;
 }
 
 void temp_arena_memory_end(Temp_Arena_Memory temp) {
+    arena_run_destructors(temp.arena, temp.destructors);
     temp.arena->prev_offset = temp.prev_offset;
     temp.arena->curr_offset = temp.curr_offset;
 }
+
+void *arena_alloc_array(Arena *a, size_t elem_size, size_t count, size_t align) {
+    if(elem_size != 0 && count > (size_t)-1 / elem_size) {
+        return NULL;
+    }
+
+    return arena_alloc_align(a, elem_size * count, align);
+}
+
+void *arena_alloc_destructible(Arena *a, size_t elem_size, size_t count, size_t align, Arena_Destructor_Func func) {
+    size_t prev_offset = a->prev_offset;
+    size_t curr_offset = a->curr_offset;
+    Arena_Destructor *d;
+    void *ptr;
+
+    if(func == NULL) {
+        return arena_alloc_array(a, elem_size, count, align);
+    }
+
+    // The entry goes first so the objects are the last allocation, resizing them in place can't run over the entry
+    d = (Arena_Destructor *)arena_alloc_align(a, sizeof(Arena_Destructor), _Alignof(Arena_Destructor));
+    if(d == NULL) {
+        return NULL;
+    }
+
+    ptr = arena_alloc_array(a, elem_size, count, align);
+    if(ptr == NULL) {
+        a->prev_offset = prev_offset;
+        a->curr_offset = curr_offset;
+        return NULL;
+    }
+
+    d->func = func;
+    d->ptr = (unsigned char *)ptr;
+    d->count = count;
+    d->stride = elem_size;
+    d->next = a->destructors;
+    a->destructors = d;
+
+    return ptr;
+}
+
+// Runs destructors newest first, the same order in which C++ would destroy the objects
+void arena_run_destructors(Arena *a, Arena_Destructor *until) {
+    while(a->destructors != until) {
+        Arena_Destructor *d = a->destructors;
+        a->destructors = d->next;
+
+        for(size_t i = d->count; i > 0; i--) {
+            d->func(d->ptr + (i - 1) * d->stride);
+        }
+    }
+}
+
+// Lays out all the arrays of a struct-of-arrays batch with a single bounds check and a single memset
+bool arena_alloc_soa(Arena *a, size_t count, Arena_Soa_Field *fields, size_t field_count) {
+    uintptr_t base = (uintptr_t)a->buf;
+    uintptr_t offset = a->curr_offset;
+    uintptr_t start = 0, last = 0;
+
+    for(size_t i = 0; i < field_count; i++) {
+        size_t align = fields[i].align > ARENA_SOA_ALIGNMENT? fields[i].align : ARENA_SOA_ALIGNMENT;
+
+        if(fields[i].elem_size != 0 && count > (size_t)-1 / fields[i].elem_size) {
+            return false;
+        }
+
+        last = align_forward(base + offset, align) - base;
+        if(i == 0) {
+            start = last;
+        }
+        if(last > a->buf_len || fields[i].elem_size * count > a->buf_len - last) {
+            return false;
+        }
+        offset = last + fields[i].elem_size * count;
+    }
+
+    if(field_count == 0) {
+        return true;
+    }
+
+    // Offsets are taken again so no field is written when the batch does not fit
+    offset = a->curr_offset;
+    for(size_t i = 0; i < field_count; i++) {
+        size_t align = fields[i].align > ARENA_SOA_ALIGNMENT? fields[i].align : ARENA_SOA_ALIGNMENT;
+        offset = align_forward(base + offset, align) - base;
+        *fields[i].out = &a->buf[offset];
+        offset += fields[i].elem_size * count;
+    }
+
+    memset(&a->buf[start], 0, offset - start);
+    a->prev_offset = last;
+    a->curr_offset = offset;
+
+    return true;
+}
@@ -1,3 +1,6 @@
+#ifndef LIN_ALLOC_H
+#define LIN_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,15 +26,68 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+// Arrays laid out by arena_alloc_soa start on at least this alignment, so every field can be loaded with aligned
+// SIMD loads
+#ifndef ARENA_SOA_ALIGNMENT
+#define ARENA_SOA_ALIGNMENT 64
+#endif
+
 typedef struct Arena Arena;
 typedef struct Temp_Arena_Memory Temp_Arena_Memory;
+typedef struct Arena_Destructor Arena_Destructor;
+typedef struct Arena_Soa_Field Arena_Soa_Field;
+
+typedef void (*Arena_Destructor_Func)(void *ptr);
+
+// Lives in the arena right before the objects it destroys, the list is newest first
+struct Arena_Destructor {
+    Arena_Destructor *next;
+    Arena_Destructor_Func func;
+    unsigned char *ptr;
+    size_t count;
+    size_t stride;
+};
+
+struct Arena {
+    unsigned char *buf;
+    size_t buf_len;
+    size_t prev_offset;
+    size_t curr_offset;
+    Arena_Destructor *destructors;
+};
+
+struct Temp_Arena_Memory {
+	Arena *arena;
+	size_t prev_offset;
+	size_t curr_offset;
+	Arena_Destructor *destructors;
+};
+
+struct Arena_Soa_Field {
+    void **out;
+    size_t elem_size;
+    size_t align;
+};
+
+#define arena_make(a, T) ((T *)arena_alloc_align((a), sizeof(T), ALIGN_OF(T)))
+#define arena_make_array(a, T, n) ((T *)arena_alloc_array((a), sizeof(T), (n), ALIGN_OF(T)))
+
+// Types without cleanup should use the plain macros, they never touch the destructor list
+#define arena_make_destructible(a, T, func) \
+    ((T *)arena_alloc_destructible((a), sizeof(T), 1, ALIGN_OF(T), (func)))
+#define arena_make_array_destructible(a, T, n, func) \
+    ((T *)arena_alloc_destructible((a), sizeof(T), (n), ALIGN_OF(T), (func)))
 
-bool is_power_of_two(uintptr_t x);
-uintptr_t align_forward(uintptr_t ptr, size_t align);
 void *arena_alloc_align(Arena *a, size_t size, size_t align);
 void *arena_resize_align(Arena *a, void *old_memory, size_t old_size, size_t new_size, size_t align);
 
@@ -40,5 +96,16 @@ void *arena_alloc(Arena *a, size_t size);
 void *arena_resize(Arena *a, void *old_memory, size_t old_size, size_t new_size);
 void arena_free_all(Arena *a);
 
+void *arena_alloc_array(Arena *a, size_t elem_size, size_t count, size_t align);
+void *arena_alloc_destructible(Arena *a, size_t elem_size, size_t count, size_t align, Arena_Destructor_Func func);
+void arena_run_destructors(Arena *a, Arena_Destructor *until);
+bool arena_alloc_soa(Arena *a, size_t count, Arena_Soa_Field *fields, size_t field_count);
+
 Temp_Arena_Memory temp_arena_memory(Arena *a);
 void temp_arena_memory_end(Temp_Arena_Memory temp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
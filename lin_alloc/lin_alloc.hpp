@@ -0,0 +1,87 @@
+#ifndef LIN_ALLOC_HPP
+#define LIN_ALLOC_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lin_alloc.h"
+
+// Typed construction on an arena:
+//
+//     Mesh *mesh = arena_new<Mesh>(&arena, vertex_count);
+//     Vec3 *points = arena_new_array<Vec3>(&arena, 1024);
+//
+// Types with a non-trivial destructor get a destructor entry, so arena_free_all and temp_arena_memory_end destroy
+// them. Both return nullptr when the arena is full, like the C functions.
+template <typename T>
+void arena_destroy_object(void *ptr) {
+    static_cast<T *>(ptr)->~T();
+}
+
+template <typename T>
+void *arena_alloc_objects(Arena *a, std::size_t count) {
+    if(std::is_trivially_destructible<T>::value) {
+        return arena_alloc_array(a, sizeof(T), count, alignof(T));
+    }
+    return arena_alloc_destructible(a, sizeof(T), count, alignof(T), arena_destroy_object<T>);
+}
+
+// A constructor that throws leaves nothing behind for the destructor list. It may have created objects of its own,
+// those are complete and their entries sit in front of the one for ptr, so exactly that entry is unlinked.
+template <typename T>
+void arena_forget_objects(Arena *a, void *ptr) {
+    if(!std::is_trivially_destructible<T>::value) {
+        Arena_Destructor **link = &a->destructors;
+
+        while(*link != nullptr && (*link)->ptr != static_cast<unsigned char *>(ptr)) {
+            link = &(*link)->next;
+        }
+        if(*link != nullptr) {
+            *link = (*link)->next;
+        }
+    }
+}
+
+template <typename T, typename... Args>
+T *arena_new(Arena *a, Args &&...args) {
+    void *ptr = arena_alloc_objects<T>(a, 1);
+
+    if(ptr == nullptr) {
+        return nullptr;
+    }
+
+    try {
+        return ::new(ptr) T(std::forward<Args>(args)...);
+    } catch(...) {
+        arena_forget_objects<T>(a, ptr);
+        throw;
+    }
+}
+
+template <typename T>
+T *arena_new_array(Arena *a, std::size_t count) {
+    T *objects = static_cast<T *>(arena_alloc_objects<T>(a, count));
+    std::size_t i = 0;
+
+    if(objects == nullptr) {
+        return nullptr;
+    }
+
+    try {
+        for(; i < count; i++) {
+            ::new(static_cast<void *>(objects + i)) T();
+        }
+    } catch(...) {
+        while(i > 0) {
+            objects[--i].~T();
+        }
+        arena_forget_objects<T>(a, objects);
+        throw;
+    }
+
+    return objects;
+}
+
+#endif
@@ -0,0 +1,116 @@
+// Standalone check of arena alignments and resizes, build and run with:
+//
+//     cc -std=gnu11 -g lin_alloc/lin_alloc_test.c lin_alloc/lin_alloc.c -o lin_alloc_test
+//     ./lin_alloc_test
+//
+// Alignments go up to 1 GiB on a reserved 3 GiB mapping, only the pages around the blocks are ever touched.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "lin_alloc.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+#define TEST_MAPPING_SIZE ((size_t)3 << 30)
+#define TEST_MAX_ALIGNMENT_SHIFT 30
+#define TEST_BLOCK_SIZE 64
+#define TEST_BUFFER_SIZE 4096
+
+static _Alignas(4096) unsigned char test_buffer[TEST_BUFFER_SIZE];
+
+static void test_block(unsigned char *ptr, size_t alignment, unsigned char fill) {
+    assert(ptr != NULL);
+    assert(((uintptr_t)ptr & (alignment - 1)) == 0 && "Misaligned block");
+    for(size_t i = 0; i < TEST_BLOCK_SIZE; i++) {
+        assert(ptr[i] == 0 && "Block is not zeroed");
+    }
+    memset(ptr, fill, TEST_BLOCK_SIZE);
+}
+
+// A 1 byte block first puts the offset off every alignment, then a block with a large alignment follows one with a
+// small alignment and the other way round. Ending the temporary memory in LIFO order has to bring back every offset.
+static void test_arena_alignments(void) {
+    void *map = mmap(NULL, TEST_MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Arena a;
+
+    assert(map != MAP_FAILED && "Could not reserve the test mapping");
+    arena_init(&a, map, TEST_MAPPING_SIZE);
+
+    for(size_t shift = 0; shift <= TEST_MAX_ALIGNMENT_SHIFT; shift++) {
+        size_t alignment = (size_t)1 << shift;
+        size_t inner_alignment = (size_t)1 << (TEST_MAX_ALIGNMENT_SHIFT - shift);
+        Temp_Arena_Memory start, outer_temp, inner_temp;
+        unsigned char *odd, *outer, *inner;
+
+        start = temp_arena_memory(&a);
+        odd = (unsigned char *)arena_alloc_align(&a, 1, 1);
+        assert(odd != NULL);
+        *odd = 0x11;
+
+        outer_temp = temp_arena_memory(&a);
+        outer = (unsigned char *)arena_alloc_align(&a, TEST_BLOCK_SIZE, alignment);
+        test_block(outer, alignment, 0x22);
+        assert(a.prev_offset == (size_t)(outer - a.buf));
+
+        inner_temp = temp_arena_memory(&a);
+        inner = (unsigned char *)arena_alloc_align(&a, TEST_BLOCK_SIZE, inner_alignment);
+        test_block(inner, inner_alignment, 0x33);
+
+        temp_arena_memory_end(inner_temp);
+        assert(a.curr_offset == inner_temp.curr_offset && a.prev_offset == inner_temp.prev_offset);
+        assert(outer[0] == 0x22 && outer[TEST_BLOCK_SIZE - 1] == 0x22);
+        temp_arena_memory_end(outer_temp);
+        assert(a.curr_offset == outer_temp.curr_offset);
+        assert(*odd == 0x11);
+        temp_arena_memory_end(start);
+        assert(a.curr_offset == start.curr_offset && a.prev_offset == start.prev_offset);
+    }
+    assert(a.curr_offset == 0);
+
+    // An alignment that can't fit leaves the arena as it was
+    arena_alloc_align(&a, 1, 1);
+    assert(arena_alloc_align(&a, TEST_MAPPING_SIZE - 1, (size_t)1 << TEST_MAX_ALIGNMENT_SHIFT) == NULL);
+    assert(a.curr_offset == 1);
+
+    munmap(map, TEST_MAPPING_SIZE);
+}
+
+// The last block grows in place, any other block moves, and a growth that fits nowhere fails without a copy
+static void test_arena_resize(void) {
+    Arena a;
+    unsigned char *x, *y, *z;
+    size_t offset;
+
+    arena_init(&a, test_buffer, TEST_BUFFER_SIZE);
+
+    x = (unsigned char *)arena_alloc(&a, 32);
+    memset(x, 0xaa, 32);
+    y = (unsigned char *)arena_alloc(&a, 32);
+    memset(y, 0xbb, 32);
+
+    assert(arena_resize(&a, y, 32, 256) == y && "The last block grows in place");
+    assert(y[31] == 0xbb && y[32] == 0 && y[255] == 0);
+    assert(a.curr_offset == (size_t)(y - test_buffer) + 256);
+
+    offset = a.curr_offset;
+    assert(arena_resize(&a, y, 256, TEST_BUFFER_SIZE) == NULL && "Growing past the buffer has to fail");
+    assert(a.curr_offset == offset);
+
+    z = (unsigned char *)arena_resize(&a, x, 32, 64);
+    assert(z != NULL && z > y && "Only the last block grows in place");
+    assert(z[0] == 0xaa && z[31] == 0xaa && z[32] == 0);
+
+    assert(arena_resize(&a, x, 32, TEST_BUFFER_SIZE) == NULL);
+}
+
+int main(void) {
+    test_arena_alignments();
+    test_arena_resize();
+
+    printf("arena: alignments up to 1 << %d and resizes passed\n", TEST_MAX_ALIGNMENT_SHIFT);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "persistent_arena.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool persistent_arena_open(Persistent_Arena *pa, const char *path, size_t capacity) {
+    struct stat st;
+    Persistent_Arena_Header *header;
+    size_t map_len;
+    void *map;
+    bool created;
+    int fd;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    created = st.st_size == 0;
+    if(created) {
+        map_len = PERSISTENT_ARENA_HEADER_SIZE + capacity;
+        if(ftruncate(fd, (off_t)map_len) != 0) {
+            close(fd);
+            return false;
+        }
+    } else {
+        // An existing file keeps its own capacity, the argument only sizes new files
+        map_len = (size_t)st.st_size;
+        if(map_len < PERSISTENT_ARENA_HEADER_SIZE) {
+            close(fd);
+            return false;
+        }
+    }
+
+    map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    header = (Persistent_Arena_Header *)map;
+    if(created) {
+        header->magic = PERSISTENT_ARENA_MAGIC;
+        header->version = PERSISTENT_ARENA_VERSION;
+        header->header_size = PERSISTENT_ARENA_HEADER_SIZE;
+        header->capacity = capacity;
+        header->curr_offset = 0;
+        header->prev_offset = 0;
+        header->root = PERSISTENT_ARENA_NULL;
+    } else if(header->magic != PERSISTENT_ARENA_MAGIC || header->version != PERSISTENT_ARENA_VERSION ||
+              header->header_size != PERSISTENT_ARENA_HEADER_SIZE ||
+              header->capacity != map_len - PERSISTENT_ARENA_HEADER_SIZE ||
+              header->curr_offset > header->capacity || header->prev_offset > header->curr_offset) {
+        // Not an arena file, written by another format version or truncated
+        munmap(map, map_len);
+        close(fd);
+        return false;
+    }
+
+    pa->map = (unsigned char *)map;
+    pa->map_len = map_len;
+    pa->header = header;
+    pa->fd = fd;
+
+    // Restoring is only setting the offsets back, the data itself is paged in on first touch
+    arena_init(&pa->arena, pa->map + PERSISTENT_ARENA_HEADER_SIZE, (size_t)header->capacity);
+    pa->arena.curr_offset = (size_t)header->curr_offset;
+    pa->arena.prev_offset = (size_t)header->prev_offset;
+    pa->root = header->root;
+
+    return true;
+}
+
+bool persistent_arena_snapshot(Persistent_Arena *pa) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t used = PERSISTENT_ARENA_HEADER_SIZE + pa->arena.curr_offset;
+
+    // The data has to be on disk before the header points past it, otherwise a crash could leave offsets to garbage
+    used = (used + page_size - 1) & ~(page_size - 1);
+    if(used > pa->map_len) {
+        used = pa->map_len;
+    }
+    if(msync(pa->map, used, MS_SYNC) != 0) {
+        return false;
+    }
+
+    pa->header->curr_offset = pa->arena.curr_offset;
+    pa->header->prev_offset = pa->arena.prev_offset;
+    pa->header->root = pa->root;
+
+    return msync(pa->map, page_size < pa->map_len? page_size : pa->map_len, MS_SYNC) == 0;
+}
+
+// Does not snapshot, reopening restores the offsets of the last snapshot
+void persistent_arena_close(Persistent_Arena *pa) {
+    munmap(pa->map, pa->map_len);
+    close(pa->fd);
+
+    pa->map = NULL;
+    pa->map_len = 0;
+    pa->header = NULL;
+    pa->root = PERSISTENT_ARENA_NULL;
+    pa->fd = -1;
+}
+
+Arena_Offset persistent_arena_offset_of(Persistent_Arena *pa, void *ptr) {
+    if(ptr == NULL) {
+        return PERSISTENT_ARENA_NULL;
+    }
+
+    if(!(pa->map <= (unsigned char *)ptr && (unsigned char *)ptr < pa->map + pa->map_len)) {
+        assert(0 && "Memory is out of bounds of the buffer in this arena");
+        return PERSISTENT_ARENA_NULL;
+    }
+
+    return (Arena_Offset)((unsigned char *)ptr - pa->map);
+}
+
+void *persistent_arena_ptr_of(Persistent_Arena *pa, Arena_Offset offset) {
+    if(offset == PERSISTENT_ARENA_NULL) {
+        return NULL;
+    }
+
+    assert(offset < pa->map_len && "Offset is out of bounds of the buffer in this arena");
+    return pa->map + offset;
+}
+
+void persistent_arena_set_root(Persistent_Arena *pa, void *root) {
+    pa->root = persistent_arena_offset_of(pa, root);
+}
+
+void *persistent_arena_root(Persistent_Arena *pa) {
+    return persistent_arena_ptr_of(pa, pa->root);
+}
+
+void relative_ptr_store(int64_t *field, void *target) {
+    *field = target == NULL? 0 : (int64_t)((intptr_t)target - (intptr_t)field);
+}
+
+// A distance of 0 would point at the field itself, so it is used as NULL
+void *relative_ptr_load(int64_t *field) {
+    return *field == 0? NULL : (void *)((intptr_t)field + (intptr_t)*field);
+}
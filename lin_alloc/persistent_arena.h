@@ -0,0 +1,88 @@
+#ifndef PERSISTENT_ARENA_H
+#define PERSISTENT_ARENA_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "lin_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// "PARENA01" read as a little-endian integer
+#define PERSISTENT_ARENA_MAGIC 0x3130414e45524150ull
+#define PERSISTENT_ARENA_VERSION 1
+
+// The data starts this far into the file, which keeps the first allocation aligned for anything
+#define PERSISTENT_ARENA_HEADER_SIZE 64
+
+// Offsets are taken from the start of the mapping, the header lives at 0 so no allocation can ever be there
+#define PERSISTENT_ARENA_NULL ((Arena_Offset)0)
+
+typedef uint64_t Arena_Offset;
+
+typedef struct Persistent_Arena_Header Persistent_Arena_Header;
+struct Persistent_Arena_Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;
+    uint64_t curr_offset;
+    uint64_t prev_offset;
+
+    // Entry point into the persisted data, e.g. the root of an index
+    Arena_Offset root;
+};
+
+typedef struct Persistent_Arena Persistent_Arena;
+struct Persistent_Arena {
+    Arena arena;
+    Persistent_Arena_Header *header;
+    // Only written to the header by a snapshot, the file never points at data that isn't on disk yet
+    Arena_Offset root;
+    unsigned char *map;
+    size_t map_len;
+    int fd;
+};
+
+bool persistent_arena_open(Persistent_Arena *pa, const char *path, size_t capacity);
+bool persistent_arena_snapshot(Persistent_Arena *pa);
+void persistent_arena_close(Persistent_Arena *pa);
+
+Arena_Offset persistent_arena_offset_of(Persistent_Arena *pa, void *ptr);
+void *persistent_arena_ptr_of(Persistent_Arena *pa, Arena_Offset offset);
+void persistent_arena_set_root(Persistent_Arena *pa, void *root);
+void *persistent_arena_root(Persistent_Arena *pa);
+
+// Self-relative pointers store the distance from the field itself, so they need no base at all
+void relative_ptr_store(int64_t *field, void *target);
+void *relative_ptr_load(int64_t *field);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
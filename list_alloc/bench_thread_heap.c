@@ -0,0 +1,209 @@
+// Compares per-thread heaps against one Free_List behind a mutex, build and run with:
+//
+//     cc -std=gnu11 -O2 -o bench_thread_heap list_alloc/bench_thread_heap.c list_alloc/thread_heap.c
+//         list_alloc/list_alloc.c pool_alloc/pool_alloc.c -lpthread
+//     ./bench_thread_heap
+//
+// Producers allocate blocks and hand them to a consumer thread through a ring, the consumer frees them. Every free is
+// a cross-thread free, the worst case for the thread heaps since those go through the remote list of the page. In
+// the local case every thread frees its own blocks right away.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "thread_heap.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_MAX_PAIRS 4
+#define BENCH_BLOCKS_PER_PRODUCER (1 << 20)
+#define BENCH_RING_SIZE 1024
+#define BENCH_LIVE 64
+#define BENCH_PAGE_BUFFER_SIZE (64*1024*1024)
+#define BENCH_LARGE_BUFFER_SIZE (1024*1024)
+#define BENCH_LIST_BUFFER_SIZE (64*1024*1024)
+
+typedef struct Bench_Ring Bench_Ring;
+struct Bench_Ring {
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t head;
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t tail;
+    void *slots[BENCH_RING_SIZE];
+};
+
+typedef struct Bench_Pair Bench_Pair;
+struct Bench_Pair {
+    Bench_Ring ring;
+    bool use_heap;
+    uint64_t seed;
+};
+
+static Thread_Heap_Global bench_global;
+static Free_List bench_list;
+static pthread_mutex_t bench_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static Bench_Pair bench_pairs[BENCH_MAX_PAIRS];
+
+static _Alignas(THREAD_HEAP_PAGE_SIZE) unsigned char bench_pages[BENCH_PAGE_BUFFER_SIZE];
+static unsigned char bench_large[BENCH_LARGE_BUFFER_SIZE];
+static unsigned char bench_list_buffer[BENCH_LIST_BUFFER_SIZE];
+
+static _Thread_local Thread_Heap bench_heap;
+
+static size_t bench_size(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (size_t)(16 + *state % 240);
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void *bench_alloc(bool use_heap, size_t size) {
+    void *ptr;
+
+    if(use_heap) {
+        return thread_heap_alloc(&bench_heap, size);
+    }
+
+    pthread_mutex_lock(&bench_list_lock);
+    ptr = free_list_alloc(&bench_list, size, DEFAULT_ALIGNMENT);
+    pthread_mutex_unlock(&bench_list_lock);
+
+    return ptr;
+}
+
+static void bench_free(bool use_heap, void *ptr) {
+    if(use_heap) {
+        thread_heap_free(&bench_heap, ptr);
+        return;
+    }
+
+    pthread_mutex_lock(&bench_list_lock);
+    free_list_free(&bench_list, ptr);
+    pthread_mutex_unlock(&bench_list_lock);
+}
+
+// The threads yield while the ring is full or empty, otherwise a spinning thread could hold up its partner
+static void *bench_producer(void *arg) {
+    Bench_Pair *pair = (Bench_Pair *)arg;
+    uint64_t state = pair->seed;
+
+    thread_heap_init(&bench_heap, &bench_global);
+
+    for(size_t i = 0; i < BENCH_BLOCKS_PER_PRODUCER; i++) {
+        size_t tail = atomic_load_explicit(&pair->ring.tail, memory_order_relaxed);
+        void *ptr = bench_alloc(pair->use_heap, bench_size(&state));
+
+        assert(ptr != NULL);
+        while(tail - atomic_load_explicit(&pair->ring.head, memory_order_acquire) == BENCH_RING_SIZE) {
+            sched_yield();
+        }
+        pair->ring.slots[tail % BENCH_RING_SIZE] = ptr;
+        atomic_store_explicit(&pair->ring.tail, tail + 1, memory_order_release);
+    }
+
+    thread_heap_destroy(&bench_heap);
+    return NULL;
+}
+
+static void *bench_consumer(void *arg) {
+    Bench_Pair *pair = (Bench_Pair *)arg;
+
+    thread_heap_init(&bench_heap, &bench_global);
+
+    for(size_t i = 0; i < BENCH_BLOCKS_PER_PRODUCER; i++) {
+        size_t head = atomic_load_explicit(&pair->ring.head, memory_order_relaxed);
+
+        while(atomic_load_explicit(&pair->ring.tail, memory_order_acquire) == head) {
+            sched_yield();
+        }
+        bench_free(pair->use_heap, pair->ring.slots[head % BENCH_RING_SIZE]);
+        atomic_store_explicit(&pair->ring.head, head + 1, memory_order_release);
+    }
+
+    thread_heap_destroy(&bench_heap);
+    return NULL;
+}
+
+// Keeps a small window of live blocks and frees the oldest one for every new one
+static void *bench_local(void *arg) {
+    Bench_Pair *pair = (Bench_Pair *)arg;
+    uint64_t state = pair->seed;
+    void *live[BENCH_LIVE] = {0};
+
+    thread_heap_init(&bench_heap, &bench_global);
+
+    for(size_t i = 0; i < BENCH_BLOCKS_PER_PRODUCER; i++) {
+        void **slot = &live[i % BENCH_LIVE];
+
+        if(*slot != NULL) {
+            bench_free(pair->use_heap, *slot);
+        }
+        *slot = bench_alloc(pair->use_heap, bench_size(&state));
+        assert(*slot != NULL);
+    }
+    for(size_t i = 0; i < BENCH_LIVE; i++) {
+        bench_free(pair->use_heap, live[i]);
+    }
+
+    thread_heap_destroy(&bench_heap);
+    return NULL;
+}
+
+// Returns nanoseconds per block, each block is one alloc and one free
+static double bench_run(size_t pairs, bool use_heap, bool cross_thread) {
+    pthread_t threads[2 * BENCH_MAX_PAIRS];
+    size_t thread_count = 0;
+    double start, end;
+
+    thread_heap_global_init(&bench_global, bench_pages, sizeof(bench_pages), bench_large, sizeof(bench_large));
+    free_list_init(&bench_list, bench_list_buffer, sizeof(bench_list_buffer));
+
+    start = bench_now();
+    for(size_t i = 0; i < pairs; i++) {
+        Bench_Pair *pair = &bench_pairs[i];
+
+        atomic_init(&pair->ring.head, 0);
+        atomic_init(&pair->ring.tail, 0);
+        pair->use_heap = use_heap;
+        pair->seed = 0x9e3779b97f4a7c15ull + i;
+
+        if(cross_thread) {
+            pthread_create(&threads[thread_count++], NULL, bench_producer, pair);
+            pthread_create(&threads[thread_count++], NULL, bench_consumer, pair);
+        } else {
+            pthread_create(&threads[thread_count++], NULL, bench_local, pair);
+            pthread_create(&threads[thread_count++], NULL, bench_local, pair);
+        }
+    }
+    for(size_t i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    end = bench_now();
+
+    thread_heap_global_destroy(&bench_global);
+
+    // A producer and its consumer share their blocks, two local threads each have their own
+    return (end - start) / (double)((cross_thread? 1 : 2) * pairs * BENCH_BLOCKS_PER_PRODUCER);
+}
+
+int main(void) {
+    printf("%6s %8s %14s %14s\n", "pairs", "frees", "mutex list ns", "thread heap ns");
+    for(size_t pairs = 1; pairs <= BENCH_MAX_PAIRS; pairs *= 2) {
+        for(int cross_thread = 1; cross_thread >= 0; cross_thread--) {
+            double list_ns = bench_run(pairs, false, cross_thread);
+            double heap_ns = bench_run(pairs, true, cross_thread);
+
+            printf("%6zu %8s %14.1f %14.1f\n", pairs, cross_thread? "remote" : "local", list_ns, heap_ns);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "handle_alloc.h"
+
+void handle_heap_init(Handle_Heap *hh, void *data, size_t size, Handle_Heap_Entry *table, uint32_t table_len) {
+    assert(table_len != 0);
+
+    hh->fl.policy = Placement_Policy_Find_First;
+    free_list_init(&hh->fl, data, size);
+
+    hh->table = table;
+    hh->table_len = table_len;
+
+    // Unused entries form a list through next_free, which holds handles so 0 ends it
+    for(uint32_t i = 0; i < table_len; i++) {
+        table[i].offset = 0;
+        table[i].size = 0;
+        table[i].used = false;
+        table[i].next_free = i + 2 <= table_len? i + 2 : 0;
+    }
+    hh->free_entry = 1;
+}
+
+Handle handle_heap_alloc(Handle_Heap *hh, size_t size) {
+    Handle h = hh->free_entry;
+    Handle_Heap_Entry *entry;
+    size_t block_size;
+    unsigned char *ptr;
+
+    if(h == 0) {
+        return 0;
+    }
+
+    // Rounded the same way free_list_alloc does, so the check below and the allocation agree
+    block_size = HANDLE_HEAP_ALIGNMENT + size;
+    if(block_size < sizeof(Free_List_Node)) {
+        block_size = sizeof(Free_List_Node);
+    }
+    block_size = (block_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if(free_list_find_first(&hh->fl, block_size, HANDLE_HEAP_ALIGNMENT, NULL, NULL) == NULL) {
+        if(hh->fl.size - hh->fl.used < block_size) {
+            return 0;
+        }
+
+        // There is enough memory in total, it is just scattered
+        handle_heap_compact(hh, ~(size_t)0);
+        if(free_list_find_first(&hh->fl, block_size, HANDLE_HEAP_ALIGNMENT, NULL, NULL) == NULL) {
+            return 0;
+        }
+    }
+
+    ptr = (unsigned char *)free_list_alloc(&hh->fl, block_size, HANDLE_HEAP_ALIGNMENT);
+    if(ptr == NULL) {
+        return 0;
+    }
+    *(Handle *)ptr = h;
+
+    entry = &hh->table[h - 1];
+    hh->free_entry = entry->next_free;
+    entry->offset = (size_t)(ptr + HANDLE_HEAP_ALIGNMENT - (unsigned char *)hh->fl.data);
+    entry->size = size;
+    entry->used = true;
+
+    return h;
+}
+
+void handle_heap_free(Handle_Heap *hh, Handle h) {
+    Handle_Heap_Entry *entry;
+
+    if(h == 0) {
+        return;
+    }
+
+    assert(h <= hh->table_len && "Handle is out of bounds of this handle heap");
+    entry = &hh->table[h - 1];
+    assert(entry->used && "Double free of a handle");
+
+    free_list_free(&hh->fl, (unsigned char *)hh->fl.data + entry->offset - HANDLE_HEAP_ALIGNMENT);
+
+    entry->used = false;
+    entry->next_free = hh->free_entry;
+    hh->free_entry = h;
+}
+
+// The pointer is only valid until the next compaction
+void *handle_heap_resolve(Handle_Heap *hh, Handle h) {
+    assert(h != 0 && h <= hh->table_len && hh->table[h - 1].used);
+
+    return (unsigned char *)hh->fl.data + hh->table[h - 1].offset;
+}
+
+size_t handle_heap_compact_step(Handle_Heap *hh) {
+    Free_List *fl = &hh->fl;
+    Free_List_Node *gap = fl->head;
+    Free_List_Node *next_free;
+    Free_List_Alloc_Header *header;
+    unsigned char *block, *end, *span_end, *payload;
+    size_t old_padding, new_padding, old_block_size, new_block_size, payload_size, remaining;
+    Handle h;
+
+    if(gap == NULL) {
+        return 0;
+    }
+
+    // The free list is sorted and coalesced, so the block right after the first gap is live
+    block = (unsigned char *)gap + gap->block_size;
+    end = (unsigned char *)fl->data + fl->size;
+    if(block >= end) {
+        return 0;
+    }
+
+    // All blocks use the same alignment, so the padding follows from the block address
+    old_padding = calc_padding_with_header((uintptr_t)block, HANDLE_HEAP_ALIGNMENT, sizeof(Free_List_Alloc_Header));
+    header = (Free_List_Alloc_Header *)(block + old_padding - sizeof(Free_List_Alloc_Header));
+    old_block_size = header->block_size;
+    payload = block + old_padding;
+    payload_size = old_block_size - old_padding;
+    span_end = block + old_block_size;
+    h = *(Handle *)payload;
+    next_free = gap->next;
+
+    new_padding = calc_padding_with_header((uintptr_t)gap, HANDLE_HEAP_ALIGNMENT, sizeof(Free_List_Alloc_Header));
+    new_block_size = new_padding + payload_size;
+    remaining = (size_t)(span_end - ((unsigned char *)gap + new_block_size));
+
+    memmove((unsigned char *)gap + new_padding, payload, payload_size);
+
+    fl->head = next_free;
+    if(remaining >= sizeof(Free_List_Node)) {
+        // The gap moves up behind the block and may now touch the next free block
+        Free_List_Node *moved_gap = (Free_List_Node *)((unsigned char *)gap + new_block_size);
+        moved_gap->block_size = remaining;
+        moved_gap->purged = false;
+        free_list_node_insert(&fl->head, NULL, moved_gap);
+        free_list_coalescence(fl, NULL, moved_gap);
+    } else {
+        new_block_size += remaining;
+    }
+
+    header = (Free_List_Alloc_Header *)((unsigned char *)gap + new_padding - sizeof(Free_List_Alloc_Header));
+    header->block_size = new_block_size;
+    header->padding = new_padding - sizeof(Free_List_Alloc_Header);
+
+    fl->used += new_block_size - old_block_size;
+    fl->rover = NULL;
+    fl->rover_prev = NULL;
+
+    hh->table[h - 1].offset = (size_t)((unsigned char *)gap + new_padding + HANDLE_HEAP_ALIGNMENT - (unsigned char *)fl->data);
+
+    return payload_size;
+}
+
+// Slides live blocks down until byte_budget bytes were moved, so it can run in bounded idle time slices
+size_t handle_heap_compact(Handle_Heap *hh, size_t byte_budget) {
+    size_t moved = 0;
+
+    while(moved < byte_budget) {
+        size_t step = handle_heap_compact_step(hh);
+        if(step == 0) {
+            break;
+        }
+        moved += step;
+    }
+
+    return moved;
+}
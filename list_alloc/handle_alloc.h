@@ -0,0 +1,73 @@
+#ifndef HANDLE_ALLOC_H
+#define HANDLE_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "list_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Every block starts with a prefix holding its handle, so the compactor can find the owner of a block.
+// It is a full alignment wide to keep the payload aligned.
+#ifndef HANDLE_HEAP_ALIGNMENT
+#define HANDLE_HEAP_ALIGNMENT DEFAULT_ALIGNMENT
+#endif
+
+// 0 is never a valid handle
+typedef uint32_t Handle;
+
+typedef struct Handle_Heap_Entry Handle_Heap_Entry;
+struct Handle_Heap_Entry {
+    size_t offset;
+    size_t size;
+    uint32_t next_free;
+    bool used;
+};
+
+typedef struct Handle_Heap Handle_Heap;
+struct Handle_Heap {
+    Free_List fl;
+
+    Handle_Heap_Entry *table;
+    uint32_t table_len;
+    uint32_t free_entry;
+};
+
+void handle_heap_init(Handle_Heap *hh, void *data, size_t size, Handle_Heap_Entry *table, uint32_t table_len);
+Handle handle_heap_alloc(Handle_Heap *hh, size_t size);
+void handle_heap_free(Handle_Heap *hh, Handle h);
+void *handle_heap_resolve(Handle_Heap *hh, Handle h);
+
+size_t handle_heap_compact_step(Handle_Heap *hh);
+size_t handle_heap_compact(Handle_Heap *hh, size_t byte_budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
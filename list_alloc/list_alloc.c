@@ -1,68 +1,102 @@
-#include "list_alloc.h"
-
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size) {
-    uintptr_t p, a, modulo, padding, needed_space;
-
-    assert(is_power_of_two(alignment));
-
-    p = ptr;
-    a = alignment;
-    modulo = p & (a - 1);
-
-    padding = 0;
-    needed_space = 0;
-
-    if(modulo != 0) {
-        padding = a - modulo;
-    }
-
-    needed_space = (uintptr_t)header_size;
-
-    if(padding < needed_space) {
-        needed_space -= padding;
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 
-        if((needed_space & (a-1)) != 0) {
-            padding += a * (1+(needed_space/a));
-        } else {
-            padding += a * (needed_space/a);
-        }
-    }
+#include "list_alloc.h"
 
-    return (size_t)padding;
-}
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
 
 void free_list_free(Free_List *fl, void *ptr) {
     Free_List_Alloc_Header *header;
     Free_List_Node *free_node;
     Free_List_Node *node;
     Free_List_Node *prev_node = NULL;
+    size_t block_size, padding;
 
     if(ptr == NULL) {
         return;
     }
 
+    // The header can overlap the new node, so read it before the node is written
     header = (Free_List_Alloc_Header *)((char *)ptr - sizeof(Free_List_Alloc_Header));
-    free_node = (Free_List_Node *)header;
-    free_node->block_size = header->block_size + header->padding;
+    block_size = header->block_size;
+    padding = header->padding;
+
+    free_node = (Free_List_Node *)((char *)header - padding);
+    free_node->block_size = block_size;
     free_node->next = NULL;
+    free_node->purged = false;
 
     node = fl->head;
-    while(node != NULL) {
-        if((uintptr_t)ptr < (uintptr_t)node) {
-            free_list_node_insert(&fl->head, prev_node, free_node);
-            break;
-        }
+    while(node != NULL && (uintptr_t)node < (uintptr_t)free_node) {
         prev_node = node;
         node = node->next;
     }
+    free_list_node_insert(&fl->head, prev_node, free_node);
 
-    fl->used -= free_node->block_size;
+    fl->used -= block_size;
+
+    // Freeing below the rover can change the nodes around it, so next-fit starts over from the head
+    if(fl->rover != NULL && (uintptr_t)free_node < (uintptr_t)fl->rover) {
+        fl->rover = NULL;
+        fl->rover_prev = NULL;
+    }
 
     free_list_coalescence(fl, prev_node, free_node);
+
+    fl->purge_dirty += block_size;
+    if(fl->purge_threshold != 0 && fl->purge_dirty >= fl->purge_threshold &&
+        free_list_now_ns() - fl->purge_last_ns >= fl->purge_interval_ns) {
+        free_list_purge(fl);
+    }
+}
+
+uint64_t free_list_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void free_list_set_purge(Free_List *fl, size_t threshold, uint64_t interval_ns) {
+    fl->purge_threshold = threshold;
+    fl->purge_interval_ns = interval_ns;
+}
+
+size_t free_list_purge(Free_List *fl) {
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    size_t purged = 0;
+
+    for(Free_List_Node *node = fl->head; node != NULL; node = node->next) {
+        uintptr_t start, end;
+
+        // Nothing has touched the pages of a purged block since, so only blocks freed or merged after it are visited
+        if(node->purged) {
+            continue;
+        }
+        node->purged = true;
+
+        // Only whole pages past the node are handed back, so the list stays intact
+        start = ((uintptr_t)node + sizeof(Free_List_Node) + page_size - 1) & ~(page_size - 1);
+        end = ((uintptr_t)node + node->block_size) & ~(page_size - 1);
+
+        if(start < end) {
+#ifdef MADV_FREE
+            if(madvise((void *)start, end - start, MADV_FREE) != 0)
+#endif
+            {
+                madvise((void *)start, end - start, MADV_DONTNEED);
+            }
+            purged += (size_t)(end - start);
+        }
+    }
+
+    fl->purge_dirty = 0;
+    fl->purge_last_ns = free_list_now_ns();
+
+    return purged;
 }
 
 void *free_list_alloc(Free_List *fl, size_t size, size_t alignment) {
@@ -72,18 +106,32 @@ void *free_list_alloc(Free_List *fl, size_t size, size_t alignment) {
     size_t alignment_padding, required_space, remaining;
     Free_List_Alloc_Header *header_ptr;
 
+    Free_List_Node *next_node;
+
     if(size < sizeof(Free_List_Node)) {
         size = sizeof(Free_List_Node);
     }
 
+    // Keeps the node of a split remainder aligned
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
     if(alignment < 0) {
         alignment = 8;
     }
 
-    if(fl->policy == Placement_Policy_Find_Best) {
-        node = free_list_find_best(fl, size, alignment, &padding, &prev_node);
-    } else {
-        node = free_list_find_first(fl, size, alignment, &padding, &prev_node);
+    switch(fl->policy) {
+        case Placement_Policy_Find_Best:
+            node = free_list_find_best(fl, size, alignment, &padding, &prev_node);
+            break;
+        case Placement_Policy_Find_Next:
+            node = free_list_find_next(fl, size, alignment, &padding, &prev_node);
+            break;
+        case Placement_Policy_Find_Good:
+            node = free_list_find_good(fl, size, alignment, fl->good_fit_percent, &padding, &prev_node);
+            break;
+        default:
+            node = free_list_find_first(fl, size, alignment, &padding, &prev_node);
+            break;
     }
 
     if(node == NULL) {
@@ -95,14 +143,24 @@ void *free_list_alloc(Free_List *fl, size_t size, size_t alignment) {
     required_space = size + padding;
     remaining = node->block_size - required_space;
 
-    if(remaining > 0) {
+    if(remaining >= fl->min_split_size && remaining >= sizeof(Free_List_Node)) {
         Free_List_Node *new_node = (Free_List_Node*)((char *)node + required_space);
         new_node->block_size = remaining;
+        // The allocation only touches the front of the block, the pages of the remainder are left as they were
+        new_node->purged = node->purged;
         free_list_node_insert(&fl->head, node, new_node);
+    } else {
+        // The remainder is too small to be worth a node of its own, it stays inside this allocation
+        required_space = node->block_size;
     }
 
+    next_node = node->next;
     free_list_node_remove(&fl->head, prev_node, node);
 
+    // Next-fit continues right after this block, the node in front of it is still prev_node
+    fl->rover = next_node;
+    fl->rover_prev = prev_node;
+
     header_ptr = (Free_List_Alloc_Header *)((char *)node + alignment_padding);
     header_ptr->block_size = required_space;
     header_ptr->padding = alignment_padding;
@@ -115,11 +173,13 @@ void *free_list_alloc(Free_List *fl, size_t size, size_t alignment) {
 void free_list_coalescence(Free_List *fl, Free_List_Node *prev_node, Free_List_Node *free_node) {
     if(free_node->next != NULL && (void *)((char *)free_node + free_node->block_size) == free_node->next) {
         free_node->block_size += free_node->next->block_size;
-        free_list_node_remove(&fl->head, prev_node, free_node->next);
+        free_node->purged = free_node->purged && free_node->next->purged;
+        free_list_node_remove(&fl->head, free_node, free_node->next);
     }
 
-    if(prev_node->next != NULL && (void *)((char *)prev_node + prev_node->block_size) == free_node) {
-        prev_node->block_size += free_node->next->block_size;
+    if(prev_node != NULL && (void *)((char *)prev_node + prev_node->block_size) == free_node) {
+        prev_node->block_size += free_node->block_size;
+        prev_node->purged = prev_node->purged && free_node->purged;
         free_list_node_remove(&fl->head, prev_node, free_node);
     }
 }
@@ -129,22 +189,38 @@ void free_list_free_all(Free_List *fl) {
     Free_List_Node *first_node = (Free_List_Node *)fl->data;
     first_node->block_size = fl->size;
     first_node->next = NULL;
+    first_node->purged = false;
     fl->head = first_node;
+    fl->rover = NULL;
+    fl->rover_prev = NULL;
 }
 
 void free_list_init(Free_List *fl, void *data, size_t size) {
     fl->data = data;
     fl->size = size;
+    fl->purge_threshold = 0;
+    fl->purge_interval_ns = 0;
+    fl->purge_dirty = 0;
+    fl->purge_last_ns = 0;
+    fl->min_split_size = sizeof(Free_List_Node);
+    fl->good_fit_percent = FREE_LIST_GOOD_FIT_PERCENT;
     free_list_free_all(fl);
 }
 
 void *free_list_find_best(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node) {
+    // Only an exact fit ends the search early
+    return free_list_find_good(fl, size, alignment, 0, _padding, _prev_node);
+}
+
+void *free_list_find_good(Free_List *fl, size_t size, size_t alignment, size_t percent, size_t *_padding, Free_List_Node **_prev_node) {
     size_t smallest_diff = ~(size_t)0;
     Free_List_Node *node = fl->head;
     Free_List_Node *prev_node = NULL;
     Free_List_Node *best_node = NULL;
+    Free_List_Node *best_prev_node = NULL;
 
     size_t padding = 0;
+    size_t best_padding = 0;
 
     while(node != NULL) {
         padding = calc_padding_with_header((uintptr_t)node, (uintptr_t)alignment, sizeof(Free_List_Alloc_Header));
@@ -152,6 +228,56 @@ void *free_list_find_best(Free_List *fl, size_t size, size_t alignment, size_t *
         if(node->block_size >= required_space && (node->block_size - required_space < smallest_diff)) {
             smallest_diff = node->block_size - required_space;
             best_node = node;
+            best_prev_node = prev_node;
+            best_padding = padding;
+
+            // Good enough, the waste is within percent of the request
+            if(smallest_diff * 100 <= required_space * percent) {
+                break;
+            }
+        }
+
+        prev_node = node;
+        node = node->next;
+    }
+
+    if(_padding) {
+        *_padding = best_padding;
+    }
+
+    if(_prev_node) {
+        *_prev_node = best_prev_node;
+    }
+
+    return best_node;
+}
+
+void *free_list_find_next(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node) {
+    Free_List_Node *start = fl->rover != NULL? fl->rover : fl->head;
+    Free_List_Node *node = start;
+    Free_List_Node *prev_node = fl->rover != NULL? fl->rover_prev : NULL;
+    bool wrapped = false;
+
+    size_t padding = 0;
+
+    while(true) {
+        if(node == NULL) {
+            if(wrapped || start == fl->head) {
+                return NULL;
+            }
+            // Wrap around and search the blocks in front of the rover
+            node = fl->head;
+            prev_node = NULL;
+            wrapped = true;
+        }
+
+        if(wrapped && node == start) {
+            return NULL;
+        }
+
+        padding = calc_padding_with_header((uintptr_t)node, (uintptr_t)alignment, sizeof(Free_List_Alloc_Header));
+        if(node->block_size >= size + padding) {
+            break;
         }
 
         prev_node = node;
@@ -166,7 +292,7 @@ void *free_list_find_best(Free_List *fl, size_t size, size_t alignment, size_t *
         *_prev_node = prev_node;
     }
 
-    return best_node;
+    return node;
 }
 
 void *free_list_find_first(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node) {
@@ -199,19 +325,11 @@ void *free_list_find_first(Free_List *fl, size_t size, size_t alignment, size_t
 
 void free_list_node_insert(Free_List_Node **phead, Free_List_Node *prev_node, Free_List_Node *new_node) {
     if(prev_node == NULL) {
-        if(*phead != NULL) {
-            new_node->next = *phead;
-        } else {
-            *phead = new_node;
-        }
+        new_node->next = *phead;
+        *phead = new_node;
     } else {
-        if(prev_node->next == NULL) {
-            prev_node->next = new_node;
-            new_node->next = NULL;
-        } else {
-            new_node->next = prev_node->next;
-            prev_node->next = new_node;
-        }
+        new_node->next = prev_node->next;
+        prev_node->next = new_node;
     }
 }
 
@@ -222,3 +340,24 @@ void free_list_node_remove(Free_List_Node **phead, Free_List_Node *prev_node, Fr
         prev_node->next = del_node->next;
     }
 }
+
+void free_list_stats(Free_List *fl, Free_List_Stats *stats) {
+    stats->free_bytes = 0;
+    stats->largest_free = 0;
+    stats->node_count = 0;
+
+    for(Free_List_Node *node = fl->head; node != NULL; node = node->next) {
+        stats->free_bytes += node->block_size;
+        if(node->block_size > stats->largest_free) {
+            stats->largest_free = node->block_size;
+        }
+        stats->node_count++;
+    }
+
+    // External fragmentation, 0 when all free memory is one block and close to 1 when it is scattered
+    if(stats->free_bytes != 0) {
+        stats->fragmentation = 1.0 - (double)stats->largest_free / (double)stats->free_bytes;
+    } else {
+        stats->fragmentation = 0.0;
+    }
+}
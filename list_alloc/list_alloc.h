@@ -1,3 +1,6 @@
+#ifndef LIST_ALLOC_H
+#define LIST_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,10 +26,20 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+#ifndef FREE_LIST_GOOD_FIT_PERCENT
+#define FREE_LIST_GOOD_FIT_PERCENT 10
+#endif
+
 typedef struct Free_List_Alloc_Header Free_List_Alloc_Header;
 struct Free_List_Alloc_Header {
     size_t block_size;
@@ -37,11 +50,16 @@ typedef struct Free_List_Node Free_List_Node;
 struct Free_List_Node {
     Free_List_Node *next;
     size_t block_size;
+    // Set once the pages of the block went back to the OS, cleared when the block is freed into or merged with memory
+    // that may still be resident
+    bool purged;
 };
 
 enum Placement_Policy {
     Placement_Policy_Find_First,
-    Placement_Policy_Find_Best
+    Placement_Policy_Find_Best,
+    Placement_Policy_Find_Next,
+    Placement_Policy_Find_Good
 };
 typedef enum Placement_Policy Placement_Policy;
 
@@ -53,10 +71,31 @@ struct Free_List {
 
     Free_List_Node *head;
     Placement_Policy policy;
+
+    // Next-fit resumes from the rover, rover_prev is the node in front of it
+    Free_List_Node *rover;
+    Free_List_Node *rover_prev;
+    // Remainders smaller than this are not split off, they stay inside the allocation
+    size_t min_split_size;
+    // Good-fit takes the first block that wastes at most this percent of the request
+    size_t good_fit_percent;
+
+    // Freed bytes since the last purge, a purge runs once they reach the threshold
+    // and the interval has passed. A threshold of 0 only purges on request.
+    size_t purge_threshold;
+    uint64_t purge_interval_ns;
+    size_t purge_dirty;
+    uint64_t purge_last_ns;
+};
+
+typedef struct Free_List_Stats Free_List_Stats;
+struct Free_List_Stats {
+    size_t free_bytes;
+    size_t largest_free;
+    size_t node_count;
+    double fragmentation;
 };
 
-bool is_power_of_two(uintptr_t x);
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size);
 
 void *free_list_alloc(Free_List *fl, size_t size, size_t alignment);
 void free_list_coalescence(Free_List *fl, Free_List_Node *prev_node, Free_List_Node *free_node);
@@ -64,8 +103,22 @@ void free_list_free(Free_List *fl, void *ptr);
 void free_list_free_all(Free_List *fl);
 void free_list_init(Free_List *fl, void *data, size_t size);
 
+uint64_t free_list_now_ns(void);
+void free_list_set_purge(Free_List *fl, size_t threshold, uint64_t interval_ns);
+size_t free_list_purge(Free_List *fl);
+
 void free_list_node_insert(Free_List_Node **phead, Free_List_Node *prev_node, Free_List_Node *new_node);
 void free_list_node_remove(Free_List_Node **phead, Free_List_Node *prev_node, Free_List_Node *del_node);
 
 void *free_list_find_best(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node);
 void *free_list_find_first(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node);
+void *free_list_find_next(Free_List *fl, size_t size, size_t alignment, size_t *_padding, Free_List_Node **_prev_node);
+void *free_list_find_good(Free_List *fl, size_t size, size_t alignment, size_t percent, size_t *_padding, Free_List_Node **_prev_node);
+
+void free_list_stats(Free_List *fl, Free_List_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
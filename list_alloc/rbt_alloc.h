@@ -1,3 +1,6 @@
+#ifndef RBT_ALLOC_H
+#define RBT_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,12 +26,18 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2 * sizeof(void *))
 #endif
 
-typedef struct Free_List_Alloc_Header Free_List_Alloc_Header;
-struct Free_List_Alloc_Header {
+typedef struct RBT_Alloc_Header RBT_Alloc_Header;
+struct RBT_Alloc_Header {
   size_t block_size;
   size_t padding;
 };
@@ -56,10 +65,13 @@ struct RBT_Alloc {
   RBT_Node *head;
 };
 
-bool is_power_of_two(uintptr_t x);
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment,
-                                size_t header_size);
 
 void rbt_free(RBT_Alloc *rbt, void *ptr);
 void rbt_free_all(RBT_Alloc *rbt);
 void rbt_init(RBT_Alloc *rbt, void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
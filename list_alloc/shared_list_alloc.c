@@ -0,0 +1,230 @@
+#include "shared_list_alloc.h"
+
+#include <errno.h>
+
+// A process that dies holding the lock hands it over as EOWNERDEAD. Its operation may have stopped half way, so the
+// lock is only made usable again if the list still adds up. Otherwise live blocks can't be told apart from free ones,
+// so the lock is released without being made consistent and every later caller gets ENOTRECOVERABLE. Returns false
+// when the lock is not held.
+bool shared_free_list_lock(Shared_Free_List *sfl) {
+    int err = pthread_mutex_lock(&sfl->lock);
+
+    if(err == EOWNERDEAD) {
+        Shared_Free_List_Offset offset = sfl->head;
+        size_t free_bytes = 0;
+
+        while(offset != SHARED_FREE_LIST_NULL && offset < sfl->region_size) {
+            Shared_Free_List_Node *node = shared_free_list_node(sfl, offset);
+            free_bytes += node->block_size;
+            if(node->next != SHARED_FREE_LIST_NULL && node->next <= offset) {
+                break;
+            }
+            offset = node->next;
+        }
+
+        if(offset != SHARED_FREE_LIST_NULL || free_bytes + sfl->used != sfl->region_size - sfl->data) {
+            pthread_mutex_unlock(&sfl->lock);
+            return false;
+        }
+
+        pthread_mutex_consistent(&sfl->lock);
+        return true;
+    }
+
+    return err == 0;
+}
+
+Shared_Free_List_Node *shared_free_list_node(Shared_Free_List *sfl, Shared_Free_List_Offset offset) {
+    return offset == SHARED_FREE_LIST_NULL? NULL : (Shared_Free_List_Node *)((unsigned char *)sfl + offset);
+}
+
+Shared_Free_List *shared_free_list_init(void *region, size_t region_size) {
+    Shared_Free_List *sfl = (Shared_Free_List *)region;
+    pthread_mutexattr_t attr;
+    size_t start;
+
+    start = (sizeof(Shared_Free_List) + DEFAULT_ALIGNMENT - 1) & ~(size_t)(DEFAULT_ALIGNMENT - 1);
+    assert(region_size >= start + sizeof(Shared_Free_List_Node) && "Shared region is smaller than the free list header.");
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&sfl->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    sfl->region_size = region_size;
+    sfl->data = start;
+    shared_free_list_free_all(sfl);
+
+    // Written last, so a process that attaches early never sees a half initialized free list
+    __atomic_store_n(&sfl->magic, SHARED_FREE_LIST_MAGIC, __ATOMIC_RELEASE);
+
+    return sfl;
+}
+
+Shared_Free_List *shared_free_list_attach(void *region) {
+    Shared_Free_List *sfl = (Shared_Free_List *)region;
+
+    if(__atomic_load_n(&sfl->magic, __ATOMIC_ACQUIRE) != SHARED_FREE_LIST_MAGIC) {
+        return NULL;
+    }
+
+    return sfl;
+}
+
+// First-fit, the same walk as free_list_find_first but over offsets
+void *shared_free_list_alloc(Shared_Free_List *sfl, size_t size, size_t alignment) {
+    Shared_Free_List_Offset offset, prev = SHARED_FREE_LIST_NULL;
+    Shared_Free_List_Node *node = NULL;
+    Free_List_Alloc_Header *header;
+    size_t padding = 0, required_space = 0, remaining;
+
+    if(size < sizeof(Shared_Free_List_Node)) {
+        size = sizeof(Shared_Free_List_Node);
+    }
+
+    // Keeps the node of a split remainder aligned
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if(!shared_free_list_lock(sfl)) {
+        return NULL;
+    }
+
+    for(offset = sfl->head; offset != SHARED_FREE_LIST_NULL; offset = node->next) {
+        node = shared_free_list_node(sfl, offset);
+        padding = calc_padding_with_header((uintptr_t)node, (uintptr_t)alignment, sizeof(Free_List_Alloc_Header));
+        required_space = size + padding;
+        if(node->block_size >= required_space) {
+            break;
+        }
+        prev = offset;
+    }
+
+    if(offset == SHARED_FREE_LIST_NULL) {
+        pthread_mutex_unlock(&sfl->lock);
+        return NULL;
+    }
+
+    remaining = node->block_size - required_space;
+    if(remaining >= sizeof(Shared_Free_List_Node)) {
+        Shared_Free_List_Offset split = offset + required_space;
+        Shared_Free_List_Node *split_node = shared_free_list_node(sfl, split);
+
+        split_node->block_size = remaining;
+        split_node->next = node->next;
+        node->next = split;
+    } else {
+        // The remainder is too small to be a node of its own, it stays inside this allocation
+        required_space = node->block_size;
+    }
+
+    if(prev == SHARED_FREE_LIST_NULL) {
+        sfl->head = node->next;
+    } else {
+        shared_free_list_node(sfl, prev)->next = node->next;
+    }
+
+    header = (Free_List_Alloc_Header *)((unsigned char *)node + padding - sizeof(Free_List_Alloc_Header));
+    header->block_size = required_space;
+    header->padding = padding - sizeof(Free_List_Alloc_Header);
+
+    sfl->used += required_space;
+
+    pthread_mutex_unlock(&sfl->lock);
+
+    return (unsigned char *)header + sizeof(Free_List_Alloc_Header);
+}
+
+void shared_free_list_coalescence(Shared_Free_List *sfl, Shared_Free_List_Offset prev, Shared_Free_List_Offset offset) {
+    Shared_Free_List_Node *node = shared_free_list_node(sfl, offset);
+    Shared_Free_List_Node *prev_node = shared_free_list_node(sfl, prev);
+
+    if(node->next != SHARED_FREE_LIST_NULL && offset + node->block_size == node->next) {
+        Shared_Free_List_Node *next_node = shared_free_list_node(sfl, node->next);
+        node->block_size += next_node->block_size;
+        node->next = next_node->next;
+    }
+
+    if(prev_node != NULL && prev + prev_node->block_size == offset) {
+        prev_node->block_size += node->block_size;
+        prev_node->next = node->next;
+    }
+}
+
+void shared_free_list_free(Shared_Free_List *sfl, void *ptr) {
+    Free_List_Alloc_Header *header;
+    Shared_Free_List_Offset offset, node_offset, prev = SHARED_FREE_LIST_NULL;
+    Shared_Free_List_Node *free_node;
+    size_t block_size;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    offset = shared_free_list_offset_of(sfl, ptr);
+    if(offset < sfl->data + sizeof(Free_List_Alloc_Header)) {
+        assert(0 && "Memory is out of bounds of the buffer in this free list");
+        return;
+    }
+
+    if(!shared_free_list_lock(sfl)) {
+        // The list is past repair, the block can't be put back
+        return;
+    }
+
+    // The header can overlap the new node, so read it before the node is written
+    header = (Free_List_Alloc_Header *)((unsigned char *)ptr - sizeof(Free_List_Alloc_Header));
+    block_size = header->block_size;
+    offset = offset - sizeof(Free_List_Alloc_Header) - header->padding;
+
+    for(node_offset = sfl->head; node_offset != SHARED_FREE_LIST_NULL && node_offset < offset;
+        node_offset = shared_free_list_node(sfl, node_offset)->next) {
+        prev = node_offset;
+    }
+
+    free_node = shared_free_list_node(sfl, offset);
+    free_node->block_size = block_size;
+    free_node->next = node_offset;
+    if(prev == SHARED_FREE_LIST_NULL) {
+        sfl->head = offset;
+    } else {
+        shared_free_list_node(sfl, prev)->next = offset;
+    }
+
+    sfl->used -= block_size;
+    shared_free_list_coalescence(sfl, prev, offset);
+
+    pthread_mutex_unlock(&sfl->lock);
+}
+
+void shared_free_list_free_all(Shared_Free_List *sfl) {
+    Shared_Free_List_Node *first = shared_free_list_node(sfl, sfl->data);
+
+    first->block_size = sfl->region_size - sfl->data;
+    first->next = SHARED_FREE_LIST_NULL;
+    sfl->head = sfl->data;
+    sfl->used = 0;
+}
+
+// Offsets are what gets sent to another process, which turns it back into a pointer in its own mapping
+Shared_Free_List_Offset shared_free_list_offset_of(Shared_Free_List *sfl, void *ptr) {
+    if(ptr == NULL) {
+        return SHARED_FREE_LIST_NULL;
+    }
+
+    if(!((unsigned char *)sfl <= (unsigned char *)ptr && (unsigned char *)ptr < (unsigned char *)sfl + sfl->region_size)) {
+        assert(0 && "Memory is out of bounds of the buffer in this free list");
+        return SHARED_FREE_LIST_NULL;
+    }
+
+    return (Shared_Free_List_Offset)((unsigned char *)ptr - (unsigned char *)sfl);
+}
+
+void *shared_free_list_ptr_of(Shared_Free_List *sfl, Shared_Free_List_Offset offset) {
+    if(offset == SHARED_FREE_LIST_NULL) {
+        return NULL;
+    }
+
+    assert(offset < sfl->region_size && "Offset is out of bounds of the buffer in this free list");
+    return (unsigned char *)sfl + offset;
+}
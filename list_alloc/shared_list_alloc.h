@@ -0,0 +1,82 @@
+#ifndef SHARED_LIST_ALLOC_H
+#define SHARED_LIST_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "list_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// "SHMLIST1" read as a little-endian integer
+#define SHARED_FREE_LIST_MAGIC 0x3154534c4d4d4853ull
+
+// The free list itself sits at offset 0 of the region, so no block can ever be there
+#define SHARED_FREE_LIST_NULL ((Shared_Free_List_Offset)0)
+
+typedef uint64_t Shared_Free_List_Offset;
+
+typedef struct Shared_Free_List_Node Shared_Free_List_Node;
+struct Shared_Free_List_Node {
+    Shared_Free_List_Offset next;
+    size_t block_size;
+};
+
+// Lives at the start of the shared region, every link is an offset from it so each process can map it anywhere
+typedef struct Shared_Free_List Shared_Free_List;
+struct Shared_Free_List {
+    uint64_t magic;
+    pthread_mutex_t lock;
+
+    size_t region_size;
+    size_t used;
+    Shared_Free_List_Offset data;
+
+    // Sorted by offset, like Free_List
+    Shared_Free_List_Offset head;
+};
+
+bool shared_free_list_lock(Shared_Free_List *sfl);
+Shared_Free_List_Node *shared_free_list_node(Shared_Free_List *sfl, Shared_Free_List_Offset offset);
+void shared_free_list_coalescence(Shared_Free_List *sfl, Shared_Free_List_Offset prev, Shared_Free_List_Offset offset);
+
+Shared_Free_List *shared_free_list_init(void *region, size_t region_size);
+Shared_Free_List *shared_free_list_attach(void *region);
+void *shared_free_list_alloc(Shared_Free_List *sfl, size_t size, size_t alignment);
+void shared_free_list_free(Shared_Free_List *sfl, void *ptr);
+void shared_free_list_free_all(Shared_Free_List *sfl);
+
+Shared_Free_List_Offset shared_free_list_offset_of(Shared_Free_List *sfl, void *ptr);
+void *shared_free_list_ptr_of(Shared_Free_List *sfl, Shared_Free_List_Offset offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+#include "thread_heap.h"
+
+_Static_assert(IS_POWER_OF_TWO(THREAD_HEAP_PAGE_SIZE), "Thread heap pages must be a power of two");
+_Static_assert(IS_POWER_OF_TWO(THREAD_HEAP_MIN_BLOCK), "Thread heap size classes must be powers of two");
+
+#define THREAD_HEAP_PAGE_HEADER ALIGN_FORWARD(sizeof(Thread_Heap_Page), DEFAULT_ALIGNMENT)
+
+void thread_heap_global_init(Thread_Heap_Global *g, void *page_buf, size_t page_buf_len, void *large_buf, size_t large_buf_len) {
+    uintptr_t start = align_forward((uintptr_t)page_buf, THREAD_HEAP_PAGE_SIZE);
+    size_t skipped = (size_t)(start - (uintptr_t)page_buf);
+
+    pthread_mutex_init(&g->lock, NULL);
+
+    g->pages = (unsigned char *)start;
+    g->page_count = page_buf_len > skipped? (page_buf_len - skipped) / THREAD_HEAP_PAGE_SIZE : 0;
+    g->pages_used = 0;
+    g->free_pages = NULL;
+    g->abandoned = NULL;
+
+    free_list_init(&g->large, large_buf, large_buf_len);
+    g->large.policy = Placement_Policy_Find_Best;
+}
+
+void thread_heap_global_destroy(Thread_Heap_Global *g) {
+    pthread_mutex_destroy(&g->lock);
+}
+
+size_t thread_heap_size_class(size_t size) {
+    if(size <= THREAD_HEAP_MIN_BLOCK) {
+        return 0;
+    }
+    return (size_t)(64 - __builtin_clzll((unsigned long long)(size - 1)) - __builtin_ctz(THREAD_HEAP_MIN_BLOCK));
+}
+
+Thread_Heap_Page *thread_heap_page_of(void *ptr) {
+    return (Thread_Heap_Page *)((uintptr_t)ptr & ~((uintptr_t)THREAD_HEAP_PAGE_SIZE - 1));
+}
+
+// Takes an abandoned page of the same class first, it might have free blocks and would otherwise never be used again
+Thread_Heap_Page *thread_heap_page_acquire(Thread_Heap *h, size_t size_class) {
+    Thread_Heap_Global *g = h->global;
+    Thread_Heap_Page *page = NULL;
+    Thread_Heap_Page **link;
+    bool adopted = false;
+
+    pthread_mutex_lock(&g->lock);
+
+    for(link = &g->abandoned; *link != NULL; link = &(*link)->next) {
+        if((*link)->size_class == size_class) {
+            page = *link;
+            *link = page->next;
+            adopted = true;
+            break;
+        }
+    }
+
+    if(page == NULL && g->free_pages != NULL) {
+        page = g->free_pages;
+        g->free_pages = page->next;
+    }
+
+    if(page == NULL && g->pages_used < g->page_count) {
+        page = (Thread_Heap_Page *)(g->pages + g->pages_used * THREAD_HEAP_PAGE_SIZE);
+        g->pages_used++;
+    }
+
+    pthread_mutex_unlock(&g->lock);
+
+    if(page == NULL) {
+        return NULL;
+    }
+
+    page->prev = NULL;
+    page->next = NULL;
+
+    if(adopted) {
+        atomic_store_explicit(&page->owner, h, memory_order_release);
+        thread_heap_page_collect(page);
+        return page;
+    }
+
+    page->size_class = size_class;
+    page->used = 0;
+    pool_init(&page->pool, (unsigned char *)page + THREAD_HEAP_PAGE_HEADER, THREAD_HEAP_PAGE_SIZE - THREAD_HEAP_PAGE_HEADER,
+              (size_t)THREAD_HEAP_MIN_BLOCK << size_class, DEFAULT_ALIGNMENT);
+    atomic_init(&page->remote, NULL);
+    atomic_store_explicit(&page->owner, h, memory_order_release);
+
+    return page;
+}
+
+void thread_heap_page_release(Thread_Heap_Global *g, Thread_Heap_Page *page) {
+    atomic_store_explicit(&page->owner, NULL, memory_order_relaxed);
+
+    pthread_mutex_lock(&g->lock);
+    page->next = g->free_pages;
+    g->free_pages = page;
+    pthread_mutex_unlock(&g->lock);
+}
+
+void thread_heap_page_unlink(Thread_Heap *h, Thread_Heap_Page *page) {
+    if(page->prev != NULL) {
+        page->prev->next = page->next;
+    } else {
+        h->pages[page->size_class] = page->next;
+    }
+    if(page->next != NULL) {
+        page->next->prev = page->prev;
+    }
+    page->prev = NULL;
+    page->next = NULL;
+}
+
+void thread_heap_page_push_front(Thread_Heap *h, Thread_Heap_Page *page) {
+    Thread_Heap_Page *head = h->pages[page->size_class];
+
+    page->prev = NULL;
+    page->next = head;
+    if(head != NULL) {
+        head->prev = page;
+    }
+    h->pages[page->size_class] = page;
+}
+
+// Moves the blocks other threads freed into the local free list, with a single atomic exchange
+void thread_heap_page_collect(Thread_Heap_Page *page) {
+    Pool_Free_Node *node = atomic_exchange_explicit(&page->remote, NULL, memory_order_acquire);
+    Pool_Free_Node *tail;
+    size_t count = 1;
+
+    if(node == NULL) {
+        return;
+    }
+
+    for(tail = node; tail->next != NULL; tail = tail->next) {
+        count++;
+    }
+
+    tail->next = page->pool.head;
+    page->pool.head = node;
+    page->used -= count;
+}
+
+void thread_heap_init(Thread_Heap *h, Thread_Heap_Global *g) {
+    h->global = g;
+    for(size_t i = 0; i < THREAD_HEAP_CLASS_COUNT; i++) {
+        h->pages[i] = NULL;
+    }
+}
+
+// Pages with live blocks are abandoned instead of released, their blocks can still be freed from any thread
+void thread_heap_destroy(Thread_Heap *h) {
+    Thread_Heap_Global *g = h->global;
+
+    for(size_t i = 0; i < THREAD_HEAP_CLASS_COUNT; i++) {
+        Thread_Heap_Page *page = h->pages[i];
+
+        while(page != NULL) {
+            Thread_Heap_Page *next = page->next;
+
+            thread_heap_page_collect(page);
+            if(page->used == 0) {
+                thread_heap_page_release(g, page);
+            } else {
+                atomic_store_explicit(&page->owner, NULL, memory_order_release);
+
+                pthread_mutex_lock(&g->lock);
+                page->next = g->abandoned;
+                g->abandoned = page;
+                pthread_mutex_unlock(&g->lock);
+            }
+            page = next;
+        }
+        h->pages[i] = NULL;
+    }
+}
+
+void *thread_heap_alloc(Thread_Heap *h, size_t size) {
+    Thread_Heap_Page *page;
+    Pool_Free_Node *node;
+    size_t size_class;
+
+    if(size > THREAD_HEAP_MAX_SMALL) {
+        void *ptr;
+
+        pthread_mutex_lock(&h->global->lock);
+        ptr = free_list_alloc(&h->global->large, size, DEFAULT_ALIGNMENT);
+        pthread_mutex_unlock(&h->global->lock);
+
+        return ptr;
+    }
+
+    size_class = thread_heap_size_class(size);
+    page = h->pages[size_class];
+
+    // The first page almost always has a free block, the others are only visited when it runs dry
+    while(page != NULL && page->pool.head == NULL) {
+        Thread_Heap_Page *next = page->next;
+
+        thread_heap_page_collect(page);
+        if(page->pool.head != NULL) {
+            if(page->used == 0 && page != h->pages[size_class]) {
+                // Emptied by remote frees, the page goes back so other classes and heaps can use it
+                thread_heap_page_unlink(h, page);
+                thread_heap_page_release(h->global, page);
+            } else {
+                break;
+            }
+        }
+        page = next;
+    }
+
+    if(page == NULL) {
+        while((page = thread_heap_page_acquire(h, size_class)) != NULL) {
+            thread_heap_page_push_front(h, page);
+            if(page->pool.head != NULL) {
+                break;
+            }
+        }
+        if(page == NULL) {
+            return NULL;
+        }
+    } else if(page != h->pages[size_class]) {
+        thread_heap_page_unlink(h, page);
+        thread_heap_page_push_front(h, page);
+    }
+
+    // Like malloc the block is not zeroed
+    node = page->pool.head;
+    page->pool.head = node->next;
+    page->used++;
+
+    return node;
+}
+
+// h is the heap of the calling thread. Blocks of its own pages are freed without any atomics, blocks of other heaps
+// are pushed onto the remote list of their page, which the owner drains when it runs out.
+void thread_heap_free(Thread_Heap *h, void *ptr) {
+    Thread_Heap_Global *g = h->global;
+    Thread_Heap_Page *page;
+    Pool_Free_Node *node = (Pool_Free_Node *)ptr;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    if(g->large.data <= ptr && ptr < (void *)((char *)g->large.data + g->large.size)) {
+        pthread_mutex_lock(&g->lock);
+        free_list_free(&g->large, ptr);
+        pthread_mutex_unlock(&g->lock);
+        return;
+    }
+
+    page = thread_heap_page_of(ptr);
+
+    if(atomic_load_explicit(&page->owner, memory_order_relaxed) == h) {
+        pool_free(&page->pool, ptr);
+        page->used--;
+
+        if(page->used == 0 && page != h->pages[page->size_class]) {
+            thread_heap_page_unlink(h, page);
+            thread_heap_page_release(g, page);
+        }
+        return;
+    }
+
+    node->next = atomic_load_explicit(&page->remote, memory_order_relaxed);
+    while(!atomic_compare_exchange_weak_explicit(&page->remote, &node->next, node,
+                                                 memory_order_release, memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef THREAD_HEAP_H
+#define THREAD_HEAP_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "list_alloc.h"
+#include "../pool_alloc/pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pages are aligned to their size, so the page of any small block is found by masking its address
+#ifndef THREAD_HEAP_PAGE_SIZE
+#define THREAD_HEAP_PAGE_SIZE (64*1024)
+#endif
+
+// Size classes are powers of two from THREAD_HEAP_MIN_BLOCK up, larger sizes go to the shared Free_List
+#ifndef THREAD_HEAP_MIN_BLOCK
+#define THREAD_HEAP_MIN_BLOCK 16
+#endif
+
+#ifndef THREAD_HEAP_CLASS_COUNT
+#define THREAD_HEAP_CLASS_COUNT 10
+#endif
+
+#define THREAD_HEAP_MAX_SMALL ((size_t)THREAD_HEAP_MIN_BLOCK << (THREAD_HEAP_CLASS_COUNT - 1))
+
+typedef struct Thread_Heap_Page Thread_Heap_Page;
+typedef struct Thread_Heap_Global Thread_Heap_Global;
+typedef struct Thread_Heap Thread_Heap;
+
+// The C++ side only ever sees pointers to pages, the layout uses C atomics
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+// Sits at the start of every page, the blocks follow it
+struct Thread_Heap_Page {
+    // Only the owner uses pool and used, other threads only read owner and push onto remote
+    _Atomic(Thread_Heap *) owner;
+    Thread_Heap_Page *prev;
+    Thread_Heap_Page *next;
+    size_t size_class;
+    size_t used;
+    Pool pool;
+
+    _Atomic(Pool_Free_Node *) remote;
+};
+#endif
+
+// Shared by all heaps, only touched under the lock when a heap needs or returns a page, or for large blocks
+struct Thread_Heap_Global {
+    pthread_mutex_t lock;
+    Free_List large;
+
+    unsigned char *pages;
+    size_t page_count;
+    size_t pages_used;
+
+    Thread_Heap_Page *free_pages;
+    // Pages of destroyed heaps that still have live blocks, another heap adopts them
+    Thread_Heap_Page *abandoned;
+};
+
+// One per thread, it is never shared so the common alloc and free touch no shared state
+struct Thread_Heap {
+    Thread_Heap_Global *global;
+    Thread_Heap_Page *pages[THREAD_HEAP_CLASS_COUNT];
+};
+
+void thread_heap_global_init(Thread_Heap_Global *g, void *page_buf, size_t page_buf_len, void *large_buf, size_t large_buf_len);
+void thread_heap_global_destroy(Thread_Heap_Global *g);
+
+size_t thread_heap_size_class(size_t size);
+Thread_Heap_Page *thread_heap_page_of(void *ptr);
+Thread_Heap_Page *thread_heap_page_acquire(Thread_Heap *h, size_t size_class);
+void thread_heap_page_release(Thread_Heap_Global *g, Thread_Heap_Page *page);
+void thread_heap_page_unlink(Thread_Heap *h, Thread_Heap_Page *page);
+void thread_heap_page_push_front(Thread_Heap *h, Thread_Heap_Page *page);
+void thread_heap_page_collect(Thread_Heap_Page *page);
+
+void thread_heap_init(Thread_Heap *h, Thread_Heap_Global *g);
+void thread_heap_destroy(Thread_Heap *h);
+
+void *thread_heap_alloc(Thread_Heap *h, size_t size);
+void thread_heap_free(Thread_Heap *h, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
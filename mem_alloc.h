@@ -0,0 +1,87 @@
+#ifndef MEM_ALLOC_H
+#define MEM_ALLOC_H
+
+// Includes every allocator. Define MEM_ALLOC_IMPLEMENTATION before including this in exactly one source file to also
+// compile all of them into that file:
+//
+//     #define MEM_ALLOC_IMPLEMENTATION
+//     #include "mem_alloc.h"
+//
+// The program then has to be linked with -lpthread -lm. C++ code can include this too, but the implementation has to
+// be compiled as C. Types that use C atomics (Epoch_Pool, Epoch_Thread, Thread_Heap_Page, Concurrent_Buddy_Block,
+// Frame_Heap) are opaque from C++ and only handled through pointers.
+
+// Some allocators need Linux APIs, this has to come before the first system header
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "core/align.h"
+
+#include "lin_alloc/lin_alloc.h"
+#include "lin_alloc/persistent_arena.h"
+#include "lin_alloc/arena_containers.h"
+
+#include "stack_alloc/stack_alloc.h"
+#include "stack_alloc/strict_stack_alloc.h"
+#include "stack_alloc/double_stack_alloc.h"
+
+#include "pool_alloc/pool_alloc.h"
+#include "pool_alloc/magazine_alloc.h"
+#include "pool_alloc/epoch_pool.h"
+#include "pool_alloc/index_pool.h"
+#include "pool_alloc/bitmap_pool.h"
+#include "pool_alloc/shared_pool.h"
+#include "pool_alloc/frame_pool.h"
+
+#include "list_alloc/list_alloc.h"
+#include "list_alloc/rbt_alloc.h"
+#include "list_alloc/handle_alloc.h"
+#include "list_alloc/shared_list_alloc.h"
+#include "list_alloc/thread_heap.h"
+
+#include "buddy_alloc/buddy_alloc.h"
+#include "buddy_alloc/concurrent_buddy_alloc.h"
+
+#include "ring_alloc/ring_alloc.h"
+#include "guarded_alloc/guarded_alloc.h"
+#include "numa_alloc/numa_alloc.h"
+#include "heap_prof/heap_prof.h"
+
+#include "compose/compose.h"
+
+#ifdef MEM_ALLOC_IMPLEMENTATION
+
+#include "lin_alloc/lin_alloc.c"
+#include "lin_alloc/persistent_arena.c"
+#include "lin_alloc/arena_containers.c"
+
+#include "stack_alloc/stack_alloc.c"
+#include "stack_alloc/strict_stack_alloc.c"
+#include "stack_alloc/double_stack_alloc.c"
+
+#include "pool_alloc/pool_alloc.c"
+#include "pool_alloc/magazine_alloc.c"
+#include "pool_alloc/epoch_pool.c"
+#include "pool_alloc/index_pool.c"
+#include "pool_alloc/bitmap_pool.c"
+#include "pool_alloc/shared_pool.c"
+#include "pool_alloc/frame_pool.c"
+
+#include "list_alloc/list_alloc.c"
+#include "list_alloc/rbt_alloc.c"
+#include "list_alloc/handle_alloc.c"
+#include "list_alloc/shared_list_alloc.c"
+#include "list_alloc/thread_heap.c"
+
+#include "buddy_alloc/buddy_alloc.c"
+#include "buddy_alloc/concurrent_buddy_alloc.c"
+
+#include "ring_alloc/ring_alloc.c"
+#include "guarded_alloc/guarded_alloc.c"
+#include "numa_alloc/numa_alloc.c"
+#include "heap_prof/heap_prof.c"
+
+#endif
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "numa_alloc.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Taken from <numaif.h>, so libnuma is not needed to build this
+#define NUMA_MPOL_BIND 2
+
+void numa_topology_init(Numa_Topology *t) {
+    char line[256];
+    char *cursor;
+    FILE *f;
+
+    t->node_count = 0;
+
+    f = fopen("/sys/devices/system/node/online", "r");
+    if(f != NULL) {
+        if(fgets(line, sizeof(line), f) != NULL) {
+            cursor = line;
+            // The list has the form "0", "0-1" or "0,2-3"
+            while(*cursor != '\0' && *cursor != '\n') {
+                unsigned long first, last;
+                char *end;
+
+                first = strtoul(cursor, &end, 10);
+                if(end == cursor) {
+                    break;
+                }
+                last = first;
+                cursor = end;
+
+                if(*cursor == '-') {
+                    cursor++;
+                    last = strtoul(cursor, &end, 10);
+                    cursor = end;
+                }
+
+                for(unsigned long id = first; id <= last && id < NUMA_MAX_NODES; id++) {
+                    t->node_ids[t->node_count++] = (unsigned)id;
+                }
+
+                if(*cursor == ',') {
+                    cursor++;
+                }
+            }
+        }
+        fclose(f);
+    }
+
+    if(t->node_count == 0) {
+        // No NUMA information, treat the machine as a single node
+        t->node_ids[0] = 0;
+        t->node_count = 1;
+    }
+}
+
+size_t numa_topology_current(Numa_Topology *t) {
+    unsigned cpu, node;
+
+    if(t->node_count == 1) {
+        return 0;
+    }
+
+    if(syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+        return 0;
+    }
+
+    for(size_t i = 0; i < t->node_count; i++) {
+        if(t->node_ids[i] == node) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+size_t numa_region_find(Numa_Region *regions, size_t count, void *ptr) {
+    for(size_t i = 0; i < count; i++) {
+        void *start = regions[i].buf;
+        void *end = &regions[i].buf[regions[i].buf_len];
+
+        if(start <= ptr && ptr < end) {
+            return i;
+        }
+    }
+
+    return count;
+}
+
+bool numa_region_init(Numa_Region *r, Numa_Topology *t, size_t index, size_t size) {
+    void *buf;
+
+    assert(index < t->node_count);
+
+    buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buf == MAP_FAILED) {
+        return false;
+    }
+
+    if(t->node_count > 1) {
+        unsigned long mask[(NUMA_MAX_NODES + 8*sizeof(unsigned long) - 1) / (8*sizeof(unsigned long))] = {0};
+        unsigned node = t->node_ids[index];
+
+        mask[node / (8*sizeof(unsigned long))] |= 1ul << (node % (8*sizeof(unsigned long)));
+
+        // Binding has to happen before the pages are touched. If the kernel refuses it,
+        // the region still works, it just falls back to first-touch placement.
+        syscall(SYS_mbind, buf, size, NUMA_MPOL_BIND, mask, (unsigned long)(8*sizeof(mask)), 0);
+    }
+
+    r->buf = (unsigned char *)buf;
+    r->buf_len = size;
+    pthread_mutex_init(&r->lock, NULL);
+
+    return true;
+}
+
+void numa_region_destroy(Numa_Region *r) {
+    if(r->buf != NULL) {
+        munmap(r->buf, r->buf_len);
+        pthread_mutex_destroy(&r->lock);
+    }
+
+    r->buf = NULL;
+    r->buf_len = 0;
+}
+
+bool numa_pool_init(Numa_Pool *np, size_t node_buffer_length, size_t chunk_size, size_t chunk_alignment) {
+    numa_topology_init(&np->topology);
+
+    for(size_t i = 0; i < np->topology.node_count; i++) {
+        if(!numa_region_init(&np->regions[i], &np->topology, i, node_buffer_length)) {
+            np->topology.node_count = i;
+            numa_pool_destroy(np);
+            return false;
+        }
+
+        pool_init(&np->pools[i], np->regions[i].buf, np->regions[i].buf_len, chunk_size, chunk_alignment);
+    }
+
+    return true;
+}
+
+void *numa_pool_alloc(Numa_Pool *np) {
+    size_t count = np->topology.node_count;
+    size_t local = numa_topology_current(&np->topology);
+
+    // Prefer the local node and only spill to remote nodes when it is exhausted
+    for(size_t n = 0; n < count; n++) {
+        size_t i = (local + n) % count;
+        void *ptr = NULL;
+
+        pthread_mutex_lock(&np->regions[i].lock);
+        if(np->pools[i].head != NULL) {
+            ptr = pool_alloc(&np->pools[i]);
+        }
+        pthread_mutex_unlock(&np->regions[i].lock);
+
+        if(ptr != NULL) {
+            return ptr;
+        }
+    }
+
+    assert(0 && "NUMA pool allocator has no free memory");
+    return NULL;
+}
+
+void numa_pool_free(Numa_Pool *np, void *ptr) {
+    size_t i;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    // Remote frees go back to the node that owns the memory, not the caller's node
+    i = numa_region_find(np->regions, np->topology.node_count, ptr);
+    if(i == np->topology.node_count) {
+        assert(0 && "Memory is out of bounds of the buffers in this NUMA pool");
+        return;
+    }
+
+    pthread_mutex_lock(&np->regions[i].lock);
+    pool_free(&np->pools[i], ptr);
+    pthread_mutex_unlock(&np->regions[i].lock);
+}
+
+void numa_pool_free_all(Numa_Pool *np) {
+    for(size_t i = 0; i < np->topology.node_count; i++) {
+        pthread_mutex_lock(&np->regions[i].lock);
+        np->pools[i].head = NULL;
+        pool_free_all(&np->pools[i]);
+        pthread_mutex_unlock(&np->regions[i].lock);
+    }
+}
+
+void numa_pool_destroy(Numa_Pool *np) {
+    for(size_t i = 0; i < np->topology.node_count; i++) {
+        numa_region_destroy(&np->regions[i]);
+    }
+
+    np->topology.node_count = 0;
+}
+
+bool numa_arena_init(Numa_Arena *na, size_t node_buffer_length) {
+    numa_topology_init(&na->topology);
+
+    for(size_t i = 0; i < na->topology.node_count; i++) {
+        if(!numa_region_init(&na->regions[i], &na->topology, i, node_buffer_length)) {
+            na->topology.node_count = i;
+            numa_arena_destroy(na);
+            return false;
+        }
+
+        arena_init(&na->arenas[i], na->regions[i].buf, na->regions[i].buf_len);
+    }
+
+    return true;
+}
+
+void *numa_arena_alloc_align(Numa_Arena *na, size_t size, size_t align) {
+    size_t count = na->topology.node_count;
+    size_t local = numa_topology_current(&na->topology);
+
+    for(size_t n = 0; n < count; n++) {
+        size_t i = (local + n) % count;
+        void *ptr;
+
+        pthread_mutex_lock(&na->regions[i].lock);
+        ptr = arena_alloc_align(&na->arenas[i], size, align);
+        pthread_mutex_unlock(&na->regions[i].lock);
+
+        if(ptr != NULL) {
+            return ptr;
+        }
+    }
+
+    return NULL;
+}
+
+void *numa_arena_alloc(Numa_Arena *na, size_t size) {
+    return numa_arena_alloc_align(na, size, DEFAULT_ALIGNMENT);
+}
+
+void numa_arena_free_all(Numa_Arena *na) {
+    for(size_t i = 0; i < na->topology.node_count; i++) {
+        pthread_mutex_lock(&na->regions[i].lock);
+        arena_free_all(&na->arenas[i]);
+        pthread_mutex_unlock(&na->regions[i].lock);
+    }
+}
+
+void numa_arena_destroy(Numa_Arena *na) {
+    for(size_t i = 0; i < na->topology.node_count; i++) {
+        numa_region_destroy(&na->regions[i]);
+    }
+
+    na->topology.node_count = 0;
+}
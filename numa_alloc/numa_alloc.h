@@ -0,0 +1,92 @@
+#ifndef NUMA_ALLOC_H
+#define NUMA_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "../lin_alloc/lin_alloc.h"
+#include "../pool_alloc/pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NUMA_MAX_NODES
+#define NUMA_MAX_NODES 64
+#endif
+
+typedef struct Numa_Topology Numa_Topology;
+struct Numa_Topology {
+    size_t node_count;
+    // Maps an instance index to the kernel node id, the node ids don't have to be contiguous (e.g. "0,2")
+    unsigned node_ids[NUMA_MAX_NODES];
+};
+
+typedef struct Numa_Region Numa_Region;
+struct Numa_Region {
+    unsigned char *buf;
+    size_t buf_len;
+    pthread_mutex_t lock;
+};
+
+typedef struct Numa_Pool Numa_Pool;
+struct Numa_Pool {
+    Numa_Topology topology;
+    Numa_Region regions[NUMA_MAX_NODES];
+    Pool pools[NUMA_MAX_NODES];
+};
+
+typedef struct Numa_Arena Numa_Arena;
+struct Numa_Arena {
+    Numa_Topology topology;
+    Numa_Region regions[NUMA_MAX_NODES];
+    Arena arenas[NUMA_MAX_NODES];
+};
+
+void numa_topology_init(Numa_Topology *t);
+size_t numa_topology_current(Numa_Topology *t);
+size_t numa_region_find(Numa_Region *regions, size_t count, void *ptr);
+bool numa_region_init(Numa_Region *r, Numa_Topology *t, size_t index, size_t size);
+void numa_region_destroy(Numa_Region *r);
+
+bool numa_pool_init(Numa_Pool *np, size_t node_buffer_length, size_t chunk_size, size_t chunk_alignment);
+void *numa_pool_alloc(Numa_Pool *np);
+void numa_pool_free(Numa_Pool *np, void *ptr);
+void numa_pool_free_all(Numa_Pool *np);
+void numa_pool_destroy(Numa_Pool *np);
+
+bool numa_arena_init(Numa_Arena *na, size_t node_buffer_length);
+void *numa_arena_alloc_align(Numa_Arena *na, size_t size, size_t align);
+void *numa_arena_alloc(Numa_Arena *na, size_t size);
+void numa_arena_free_all(Numa_Arena *na);
+void numa_arena_destroy(Numa_Arena *na);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+// Walks the hot field of pool chunks with cache coloring off and on, build and run with:
+//
+//     cc -std=gnu11 -O2 pool_alloc/bench_coloring.c pool_alloc/pool_alloc.c -o bench_coloring
+//     ./bench_coloring
+//
+// Every chunk starts with a small hot header, like the node of a tree or a connection struct, followed by cold data.
+// With 4 KiB chunks all headers land in the same few cache sets, so once there are more of them than the cache has
+// ways they keep evicting each other even though they would easily fit.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "pool_alloc.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_CHUNK_SIZE 4096
+#define BENCH_SLAB_SIZE (64*1024)
+#define BENCH_BUFFER_SIZE (64*1024*1024)
+#define BENCH_STEPS (64*1024*1024)
+
+typedef struct Bench_Hot Bench_Hot;
+struct Bench_Hot {
+    Bench_Hot *next;
+    size_t value;
+};
+
+static _Alignas(4096) unsigned char bench_buffer[BENCH_BUFFER_SIZE];
+static Bench_Hot *bench_chunks[BENCH_BUFFER_SIZE / BENCH_CHUNK_SIZE];
+
+static uint64_t bench_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t bench_random(void) {
+    bench_state ^= bench_state << 13;
+    bench_state ^= bench_state >> 7;
+    bench_state ^= bench_state << 17;
+    return bench_state;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Links count chunks into a random cycle through their headers, so every step is a dependent load the prefetcher
+// can't guess, and returns the time per step in nanoseconds
+static double bench_walk(Pool *p, size_t count) {
+    Bench_Hot *hot;
+    size_t sum = 0;
+    double start, end;
+
+    for(size_t i = 0; i < count; i++) {
+        bench_chunks[i] = (Bench_Hot *)pool_alloc(p);
+        assert(bench_chunks[i] != NULL);
+    }
+    for(size_t i = count - 1; i > 0; i--) {
+        size_t j = (size_t)(bench_random() % (i + 1));
+        Bench_Hot *tmp = bench_chunks[i];
+        bench_chunks[i] = bench_chunks[j];
+        bench_chunks[j] = tmp;
+    }
+    for(size_t i = 0; i < count; i++) {
+        bench_chunks[i]->next = bench_chunks[(i + 1) % count];
+        bench_chunks[i]->value = i;
+    }
+
+    hot = bench_chunks[0];
+    for(size_t i = 0; i < count * 4; i++) {
+        hot = hot->next;
+    }
+
+    start = bench_now();
+    for(size_t i = 0; i < BENCH_STEPS; i++) {
+        sum += hot->value;
+        hot = hot->next;
+    }
+    end = bench_now();
+
+    // Keeps the walk from being optimized out
+    if(sum == 1) {
+        printf("%p\n", (void *)hot);
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        pool_free(p, bench_chunks[i]);
+    }
+
+    return (end - start) / BENCH_STEPS;
+}
+
+int main(void) {
+    static const size_t counts[] = {16, 64, 256, 512, 1024, 4096};
+    Pool plain, colored;
+
+    printf("%8s %12s %12s\n", "chunks", "plain ns", "colored ns");
+    for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        double plain_ns, colored_ns;
+
+        // Both pools share the buffer, each is set up again right before its walk
+        pool_init(&plain, bench_buffer, BENCH_BUFFER_SIZE, BENCH_CHUNK_SIZE, DEFAULT_ALIGNMENT);
+        plain_ns = bench_walk(&plain, counts[i]);
+
+        pool_init_colored(&colored, bench_buffer, BENCH_BUFFER_SIZE, BENCH_CHUNK_SIZE, DEFAULT_ALIGNMENT,
+                          BENCH_SLAB_SIZE, 0);
+        colored_ns = bench_walk(&colored, counts[i]);
+
+        printf("%8zu %12.2f %12.2f\n", counts[i], plain_ns, colored_ns);
+    }
+
+    return 0;
+}
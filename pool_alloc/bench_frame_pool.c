@@ -0,0 +1,138 @@
+// Compares the frame heaps against malloc for coroutine frame patterns, build and run with:
+//
+//     cc -std=gnu11 -O2 -o bench_frame_pool pool_alloc/bench_frame_pool.c pool_alloc/frame_pool.c
+//         pool_alloc/pool_alloc.c stack_alloc/stack_alloc.c -lpthread
+//     ./bench_frame_pool
+//
+// A chain of co_awaits creates one frame per level on the way down and frees them in reverse on the way up. In the
+// handoff case coroutines are created on one thread and finish on another, so every frame is freed remotely.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "frame_pool.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_DEPTH 64
+#define BENCH_CHAINS (64*1024)
+#define BENCH_HANDOFFS (4*1024*1024)
+#define BENCH_RING_SIZE 1024
+
+typedef struct Bench_Ring Bench_Ring;
+struct Bench_Ring {
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t head;
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t tail;
+    void *slots[BENCH_RING_SIZE];
+    bool use_frames;
+};
+
+static Bench_Ring bench_ring;
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Frame sizes of real coroutines cluster around a few hundred bytes, with the odd large one
+static size_t bench_size(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (*state & 63) == 0? 4000 : (size_t)(48 + *state % 720);
+}
+
+static void *bench_alloc(bool use_frames, size_t size) {
+    return use_frames? frame_alloc(frame_heap_thread(), size) : malloc(size);
+}
+
+static void bench_free(bool use_frames, void *ptr) {
+    if(use_frames) {
+        frame_free(frame_heap_thread(), ptr);
+    } else {
+        free(ptr);
+    }
+}
+
+// Returns nanoseconds per frame, one alloc plus one free
+static double bench_chains(bool use_frames) {
+    void *frames[BENCH_DEPTH];
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    double start, end;
+
+    start = bench_now();
+    for(size_t chain = 0; chain < BENCH_CHAINS; chain++) {
+        for(size_t i = 0; i < BENCH_DEPTH; i++) {
+            frames[i] = bench_alloc(use_frames, bench_size(&state));
+            // The coroutine writes its frame, so the allocator can't get away with untouched memory
+            *(volatile unsigned char *)frames[i] = (unsigned char)i;
+        }
+        for(size_t i = BENCH_DEPTH; i > 0; i--) {
+            bench_free(use_frames, frames[i - 1]);
+        }
+    }
+    end = bench_now();
+
+    return (end - start) / (double)(BENCH_CHAINS * BENCH_DEPTH);
+}
+
+// Both threads yield while the ring is full or empty, otherwise a spinning thread could hold up the other one
+static void *bench_finisher(void *arg) {
+    Bench_Ring *ring = (Bench_Ring *)arg;
+
+    for(size_t i = 0; i < BENCH_HANDOFFS; i++) {
+        size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+        while(atomic_load_explicit(&ring->tail, memory_order_acquire) == head) {
+            sched_yield();
+        }
+        bench_free(ring->use_frames, ring->slots[head % BENCH_RING_SIZE]);
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+static double bench_handoff(bool use_frames) {
+    Bench_Ring *ring = &bench_ring;
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    pthread_t finisher;
+    double start, end;
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->use_frames = use_frames;
+
+    start = bench_now();
+    pthread_create(&finisher, NULL, bench_finisher, ring);
+
+    for(size_t i = 0; i < BENCH_HANDOFFS; i++) {
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        void *ptr = bench_alloc(use_frames, bench_size(&state));
+
+        assert(ptr != NULL);
+        while(tail - atomic_load_explicit(&ring->head, memory_order_acquire) == BENCH_RING_SIZE) {
+            sched_yield();
+        }
+        ring->slots[tail % BENCH_RING_SIZE] = ptr;
+        atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    }
+
+    pthread_join(finisher, NULL);
+    end = bench_now();
+
+    return (end - start) / (double)BENCH_HANDOFFS;
+}
+
+int main(void) {
+    printf("%10s %10s %14s\n", "pattern", "malloc ns", "frame heap ns");
+    printf("%10s %10.1f %14.1f\n", "chain", bench_chains(false), bench_chains(true));
+    printf("%10s %10.1f %14.1f\n", "handoff", bench_handoff(false), bench_handoff(true));
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Compares pool_alloc_bulk and pool_free_bulk against loops of pool_alloc and pool_free, build and run with:
+//
+//     cc -std=gnu11 -O2 -o bench_pool_bulk pool_alloc/bench_pool_bulk.c pool_alloc/pool_alloc.c
+//     ./bench_pool_bulk
+//
+// The free list is shuffled first, so consecutive chunks on it are far apart in memory. Half of the pool stays live as a
+// window of bursts, every step frees the oldest burst and allocates a new one, so the free list keeps cycling through
+// chunks that are no longer in the cache.
+
+#include "pool_alloc.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_CHUNK_SIZE 64
+#define BENCH_CHUNK_COUNT (1 << 20)
+#define BENCH_LIVE_CHUNKS (BENCH_CHUNK_COUNT / 2)
+#define BENCH_OBJECTS (16 * BENCH_CHUNK_COUNT)
+#define BENCH_MIN_BURST 32
+#define BENCH_MAX_BURST 256
+
+static _Alignas(4096) unsigned char bench_buffer[BENCH_CHUNK_COUNT * BENCH_CHUNK_SIZE];
+static void *bench_chunks[BENCH_CHUNK_COUNT];
+static void *bench_live[BENCH_LIVE_CHUNKS];
+
+static Pool bench_pool;
+
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Takes every chunk and hands them back in a random order
+static void bench_scatter(Pool *p) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    size_t count;
+
+    pool_free_all(p);
+    count = pool_alloc_bulk(p, bench_chunks, BENCH_CHUNK_COUNT);
+    assert(count == BENCH_CHUNK_COUNT);
+
+    for(size_t i = count - 1; i > 0; i--) {
+        size_t j = (size_t)(bench_random(&state) % (i + 1));
+        void *tmp = bench_chunks[i];
+
+        bench_chunks[i] = bench_chunks[j];
+        bench_chunks[j] = tmp;
+    }
+    pool_free_bulk(p, bench_chunks, count);
+}
+
+static void bench_take(Pool *p, void **out, size_t burst, bool bulk) {
+    if(bulk) {
+        size_t count = pool_alloc_bulk(p, out, burst);
+        assert(count == burst);
+        (void)count;
+        return;
+    }
+
+    for(size_t i = 0; i < burst; i++) {
+        out[i] = pool_alloc(p);
+    }
+}
+
+static void bench_give(Pool *p, void **ptrs, size_t burst, bool bulk) {
+    if(bulk) {
+        pool_free_bulk(p, ptrs, burst);
+        return;
+    }
+
+    for(size_t i = 0; i < burst; i++) {
+        pool_free(p, ptrs[i]);
+    }
+}
+
+// Returns nanoseconds per object, one alloc plus one free
+static double bench_run(size_t burst, bool bulk) {
+    Pool *p = &bench_pool;
+    size_t window = BENCH_LIVE_CHUNKS / burst;
+    double start, end;
+
+    bench_scatter(p);
+    for(size_t i = 0; i < window; i++) {
+        bench_take(p, &bench_live[i * burst], burst, bulk);
+    }
+
+    start = bench_now();
+    for(size_t step = 0; step < BENCH_OBJECTS / burst; step++) {
+        void **slot = &bench_live[(step % window) * burst];
+
+        bench_give(p, slot, burst, bulk);
+        bench_take(p, slot, burst, bulk);
+    }
+    end = bench_now();
+
+    return (end - start) / (double)BENCH_OBJECTS;
+}
+
+int main(void) {
+    pool_init(&bench_pool, bench_buffer, sizeof(bench_buffer), BENCH_CHUNK_SIZE, DEFAULT_ALIGNMENT);
+
+    printf("%6s %10s %10s\n", "burst", "single ns", "bulk ns");
+    for(size_t burst = BENCH_MIN_BURST; burst <= BENCH_MAX_BURST; burst *= 2) {
+        double single_ns = bench_run(burst, false);
+        double bulk_ns = bench_run(burst, true);
+
+        printf("%6zu %10.1f %10.1f\n", burst, single_ns, bulk_ns);
+    }
+
+    return 0;
+}
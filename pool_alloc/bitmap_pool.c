@@ -0,0 +1,254 @@
+#include "bitmap_pool.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Returns the first word at or after the given one with a free chunk, or word_count if there is none
+size_t bitmap_pool_find_free_word(Bitmap_Pool *bp, size_t word) {
+#ifdef __AVX2__
+    __m256i full = _mm256_set1_epi64x(-1);
+
+    // Four words per compare, the scalar loop below only finishes an unaligned start
+    while(word % BITMAP_POOL_WORD_GROUP != 0 && word < bp->word_count) {
+        if(bp->bitmap[word] != ~(uint64_t)0) {
+            return word;
+        }
+        word++;
+    }
+
+    for(; word < bp->word_count; word += BITMAP_POOL_WORD_GROUP) {
+        __m256i v = _mm256_load_si256((const __m256i *)&bp->bitmap[word]);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, full)));
+
+        if(mask != 0xF) {
+            return word + (size_t)__builtin_ctz(~mask & 0xF);
+        }
+    }
+#else
+    for(; word < bp->word_count; word++) {
+        if(bp->bitmap[word] != ~(uint64_t)0) {
+            return word;
+        }
+    }
+#endif
+
+    return bp->word_count;
+}
+
+// Returns the first bit in [bit, limit) that is live (or free), or limit if there is none
+size_t bitmap_pool_find_bit(Bitmap_Pool *bp, size_t bit, size_t limit, bool live) {
+    size_t word = bit / BITMAP_POOL_WORD_BITS;
+    uint64_t bits;
+
+    if(bit >= limit) {
+        return limit;
+    }
+
+    bits = live? bp->bitmap[word] : ~bp->bitmap[word];
+    bits &= ~(uint64_t)0 << (bit % BITMAP_POOL_WORD_BITS);
+
+    while(bits == 0) {
+        word++;
+        if(word * BITMAP_POOL_WORD_BITS >= limit) {
+            return limit;
+        }
+        bits = live? bp->bitmap[word] : ~bp->bitmap[word];
+    }
+
+    bit = word * BITMAP_POOL_WORD_BITS + (size_t)__builtin_ctzll(bits);
+    return bit < limit? bit : limit;
+}
+
+void bitmap_pool_set_range(Bitmap_Pool *bp, size_t bit, size_t n, bool live) {
+    while(n > 0) {
+        size_t word = bit / BITMAP_POOL_WORD_BITS;
+        size_t shift = bit % BITMAP_POOL_WORD_BITS;
+        size_t count = BITMAP_POOL_WORD_BITS - shift < n? BITMAP_POOL_WORD_BITS - shift : n;
+        uint64_t mask = (count == BITMAP_POOL_WORD_BITS? ~(uint64_t)0 : (((uint64_t)1 << count) - 1)) << shift;
+
+        if(live) {
+            bp->bitmap[word] |= mask;
+        } else {
+            bp->bitmap[word] &= ~mask;
+        }
+
+        bit += count;
+        n -= count;
+    }
+}
+
+size_t bitmap_pool_index_of(Bitmap_Pool *bp, void *ptr) {
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)bp->buf;
+
+    if(!((uintptr_t)bp->buf <= (uintptr_t)ptr && offset < (uintptr_t)(bp->chunk_count * bp->chunk_size))) {
+        assert(0 && "Memory is out of bounds of the buffer in this pool");
+        return bp->chunk_count;
+    }
+
+    assert(offset % bp->chunk_size == 0 && "Pointer does not point at the start of a chunk");
+    return (size_t)(offset / bp->chunk_size);
+}
+
+void *bitmap_pool_alloc(Bitmap_Pool *bp) {
+    size_t word = bitmap_pool_find_free_word(bp, bp->hint);
+    size_t index;
+
+    bp->hint = word;
+    if(word == bp->word_count) {
+        assert(0 && "Pool allocator has no free memory");
+        return NULL;
+    }
+
+    index = word * BITMAP_POOL_WORD_BITS + (size_t)__builtin_ctzll(~bp->bitmap[word]);
+    bp->bitmap[word] |= (uint64_t)1 << (index % BITMAP_POOL_WORD_BITS);
+
+    return memset(&bp->buf[index * bp->chunk_size], 0, bp->chunk_size);
+}
+
+void *bitmap_pool_alloc_contiguous(Bitmap_Pool *bp, size_t n) {
+    size_t bit = bp->hint * BITMAP_POOL_WORD_BITS;
+
+    if(n == 0 || n > bp->chunk_count) {
+        return NULL;
+    }
+
+    // Jump from the start of each free run to the next live chunk, so every bit is looked at only once
+    while(bit + n <= bp->chunk_count) {
+        size_t end;
+
+        bit = bitmap_pool_find_bit(bp, bit, bp->chunk_count, false);
+        if(bit + n > bp->chunk_count) {
+            break;
+        }
+
+        end = bitmap_pool_find_bit(bp, bit, bit + n, true);
+        if(end == bit + n) {
+            bitmap_pool_set_range(bp, bit, n, true);
+            return memset(&bp->buf[bit * bp->chunk_size], 0, n * bp->chunk_size);
+        }
+
+        bit = end + 1;
+    }
+
+    return NULL;
+}
+
+void bitmap_pool_free(Bitmap_Pool *bp, void *ptr) {
+    bitmap_pool_free_contiguous(bp, ptr, 1);
+}
+
+void bitmap_pool_free_contiguous(Bitmap_Pool *bp, void *ptr, size_t n) {
+    size_t index;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    index = bitmap_pool_index_of(bp, ptr);
+    if(index >= bp->chunk_count || n > bp->chunk_count - index) {
+        return;
+    }
+
+    assert(bitmap_pool_find_bit(bp, index, index + n, false) == index + n && "Double free of a pool chunk");
+
+    bitmap_pool_set_range(bp, index, n, false);
+    if(index / BITMAP_POOL_WORD_BITS < bp->hint) {
+        bp->hint = index / BITMAP_POOL_WORD_BITS;
+    }
+}
+
+void bitmap_pool_free_all(Bitmap_Pool *bp) {
+    memset(bp->bitmap, 0, bp->word_count * sizeof(uint64_t));
+    // Bits past the last chunk stay set, so they are never handed out
+    bitmap_pool_set_range(bp, bp->chunk_count, bp->word_count * BITMAP_POOL_WORD_BITS - bp->chunk_count, true);
+    bp->hint = 0;
+}
+
+void bitmap_pool_init(Bitmap_Pool *bp, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment) {
+    uintptr_t initial_start = (uintptr_t)backing_buffer;
+    uintptr_t start = align_forward_uinptr(initial_start, (uintptr_t)chunk_alignment);
+    uintptr_t end = initial_start + backing_buffer_length;
+    size_t group_bytes = BITMAP_POOL_WORD_GROUP * sizeof(uint64_t);
+    size_t chunk_count, word_count;
+    uintptr_t bitmap;
+
+    assert(backing_buffer_length >= (size_t)(start - initial_start) && "Backing buffer is too small to be aligned.");
+
+    chunk_size = align_forward_size(chunk_size, chunk_alignment);
+
+    // Start from one bit of bitmap per chunk, then give chunks back until the padded bitmap fits behind them
+    chunk_count = (size_t)(end - start) * 8 / (chunk_size * 8 + 1);
+    for(;;) {
+        word_count = (chunk_count + BITMAP_POOL_WORD_BITS - 1) / BITMAP_POOL_WORD_BITS;
+        word_count = align_forward_size(word_count == 0? 1 : word_count, BITMAP_POOL_WORD_GROUP);
+        bitmap = align_forward_uinptr(start + chunk_count * chunk_size, group_bytes);
+
+        if(bitmap + word_count * sizeof(uint64_t) <= end || chunk_count == 0) {
+            break;
+        }
+        chunk_count--;
+    }
+
+    assert(chunk_count != 0 && "Backing buffer length is smaller than the actual size.");
+
+    bp->buf = (unsigned char *)start;
+    bp->chunk_size = chunk_size;
+    bp->chunk_count = chunk_count;
+    bp->bitmap = (uint64_t *)bitmap;
+    bp->word_count = word_count;
+
+    bitmap_pool_free_all(bp);
+}
+
+bool bitmap_pool_is_live(Bitmap_Pool *bp, void *ptr) {
+    size_t index = bitmap_pool_index_of(bp, ptr);
+
+    return index < bp->chunk_count && (bp->bitmap[index / BITMAP_POOL_WORD_BITS] >> (index % BITMAP_POOL_WORD_BITS)) & 1;
+}
+
+size_t bitmap_pool_live_count(Bitmap_Pool *bp) {
+    size_t count = 0;
+
+    for(size_t i = 0; i < bp->word_count; i++) {
+        count += (size_t)__builtin_popcountll(bp->bitmap[i]);
+    }
+
+    // Padding bits are always set, they are not chunks
+    return count - (bp->word_count * BITMAP_POOL_WORD_BITS - bp->chunk_count);
+}
+
+void bitmap_pool_iterator_init(Bitmap_Pool_Iterator *it, Bitmap_Pool *bp) {
+    it->bp = bp;
+    it->word = 0;
+    it->bits = bp->bitmap[0];
+}
+
+// Visits live chunks in address order, chunks freed during the walk are skipped once their word is reached
+void *bitmap_pool_iterator_next(Bitmap_Pool_Iterator *it) {
+    Bitmap_Pool *bp = it->bp;
+    size_t index;
+    unsigned char *chunk;
+
+    while(it->bits == 0) {
+        it->word++;
+        if(it->word * BITMAP_POOL_WORD_BITS >= bp->chunk_count) {
+            return NULL;
+        }
+        it->bits = bp->bitmap[it->word];
+    }
+
+    index = it->word * BITMAP_POOL_WORD_BITS + (size_t)__builtin_ctzll(it->bits);
+    if(index >= bp->chunk_count) {
+        it->bits = 0;
+        return NULL;
+    }
+
+    // Clear the lowest set bit
+    it->bits &= it->bits - 1;
+
+    chunk = &bp->buf[index * bp->chunk_size];
+    __builtin_prefetch(chunk + bp->chunk_size, 0);
+
+    return chunk;
+}
@@ -0,0 +1,84 @@
+#ifndef BITMAP_POOL_H
+#define BITMAP_POOL_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bits per bitmap word, a set bit is a live chunk
+#define BITMAP_POOL_WORD_BITS 64
+
+// The bitmap is padded to whole groups of words, so the SIMD scan never needs a scalar tail
+#define BITMAP_POOL_WORD_GROUP 4
+
+typedef struct Bitmap_Pool Bitmap_Pool;
+struct Bitmap_Pool {
+    unsigned char *buf;
+    size_t chunk_size;
+    size_t chunk_count;
+
+    // Carved from the end of the backing buffer, bits past the last chunk are always set
+    uint64_t *bitmap;
+    size_t word_count;
+
+    // No free chunk lives in a word below this one
+    size_t hint;
+};
+
+typedef struct Bitmap_Pool_Iterator Bitmap_Pool_Iterator;
+struct Bitmap_Pool_Iterator {
+    Bitmap_Pool *bp;
+    size_t word;
+    uint64_t bits;
+};
+
+size_t bitmap_pool_find_free_word(Bitmap_Pool *bp, size_t word);
+size_t bitmap_pool_find_bit(Bitmap_Pool *bp, size_t bit, size_t limit, bool live);
+void bitmap_pool_set_range(Bitmap_Pool *bp, size_t bit, size_t n, bool live);
+size_t bitmap_pool_index_of(Bitmap_Pool *bp, void *ptr);
+
+void *bitmap_pool_alloc(Bitmap_Pool *bp);
+void *bitmap_pool_alloc_contiguous(Bitmap_Pool *bp, size_t n);
+void bitmap_pool_free(Bitmap_Pool *bp, void *ptr);
+void bitmap_pool_free_contiguous(Bitmap_Pool *bp, void *ptr, size_t n);
+void bitmap_pool_free_all(Bitmap_Pool *bp);
+void bitmap_pool_init(Bitmap_Pool *bp, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment);
+
+bool bitmap_pool_is_live(Bitmap_Pool *bp, void *ptr);
+size_t bitmap_pool_live_count(Bitmap_Pool *bp);
+
+void bitmap_pool_iterator_init(Bitmap_Pool_Iterator *it, Bitmap_Pool *bp);
+void *bitmap_pool_iterator_next(Bitmap_Pool_Iterator *it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+#include "epoch_pool.h"
+
+#include <sched.h>
+
+void epoch_pool_init(Epoch_Pool *ep, Pool *pool) {
+    ep->pool = pool;
+    pthread_mutex_init(&ep->lock, NULL);
+    ep->threads = NULL;
+    // Epochs are stored shifted, the lowest bit of a local epoch is the active flag
+    atomic_init(&ep->global_epoch, 0);
+}
+
+void epoch_pool_destroy(Epoch_Pool *ep) {
+    assert(ep->threads == NULL && "Epoch pool destroyed with registered threads");
+
+    pthread_mutex_destroy(&ep->lock);
+    ep->pool = NULL;
+}
+
+bool epoch_thread_register(Epoch_Pool *ep, Epoch_Thread *t) {
+    for(size_t i = 0; i < EPOCH_POOL_BAGS; i++) {
+        t->limbo[i].ptrs = (void **)malloc(EPOCH_POOL_BATCH * sizeof(void *));
+        t->limbo[i].count = 0;
+        t->limbo[i].capacity = EPOCH_POOL_BATCH;
+
+        if(t->limbo[i].ptrs == NULL) {
+            while(i-- > 0) {
+                free(t->limbo[i].ptrs);
+            }
+            return false;
+        }
+    }
+
+    t->ep = ep;
+    t->seen_epoch = atomic_load(&ep->global_epoch);
+    atomic_init(&t->local_epoch, 0);
+
+    pthread_mutex_lock(&ep->lock);
+    t->next = ep->threads;
+    ep->threads = t;
+    pthread_mutex_unlock(&ep->lock);
+
+    return true;
+}
+
+void epoch_thread_unregister(Epoch_Thread *t) {
+    Epoch_Pool *ep = t->ep;
+    Epoch_Thread **link;
+
+    assert(!(atomic_load(&t->local_epoch) & EPOCH_POOL_ACTIVE) && "Unregistering a pinned thread");
+
+    // Nobody else frees this thread's bags, so wait until all of them are safe
+    epoch_pool_synchronize(ep);
+
+    pthread_mutex_lock(&ep->lock);
+    for(link = &ep->threads; *link != NULL; link = &(*link)->next) {
+        if(*link == t) {
+            *link = t->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ep->lock);
+
+    for(size_t i = 0; i < EPOCH_POOL_BAGS; i++) {
+        epoch_bag_release(ep, &t->limbo[i]);
+        free(t->limbo[i].ptrs);
+        t->limbo[i].ptrs = NULL;
+        t->limbo[i].capacity = 0;
+    }
+}
+
+void epoch_bag_release(Epoch_Pool *ep, Epoch_Bag *bag) {
+    if(bag->count == 0) {
+        return;
+    }
+
+    // One lock acquisition and one splice onto the free list for the whole batch
+    pthread_mutex_lock(&ep->lock);
+    pool_free_bulk(ep->pool, bag->ptrs, bag->count);
+    pthread_mutex_unlock(&ep->lock);
+
+    bag->count = 0;
+}
+
+void epoch_pin(Epoch_Thread *t) {
+    Epoch_Pool *ep = t->ep;
+    size_t epoch;
+
+    // The announcement only counts if the epoch did not move while it was made
+    do {
+        epoch = atomic_load(&ep->global_epoch);
+        atomic_store(&t->local_epoch, epoch | EPOCH_POOL_ACTIVE);
+    } while(atomic_load(&ep->global_epoch) != epoch);
+
+    epoch_thread_collect(t, epoch);
+}
+
+void epoch_thread_collect(Epoch_Thread *t, size_t epoch) {
+    size_t now = epoch >> 1;
+    size_t seen = t->seen_epoch >> 1;
+
+    if(now == seen) {
+        return;
+    }
+
+    // Readers can linger one epoch behind, so a bag is safe once the epoch moved two past it
+    epoch_bag_release(t->ep, &t->limbo[(seen + EPOCH_POOL_BAGS - 1) % EPOCH_POOL_BAGS]);
+    if(now - seen >= 2) {
+        epoch_bag_release(t->ep, &t->limbo[seen % EPOCH_POOL_BAGS]);
+    }
+
+    t->seen_epoch = epoch;
+}
+
+void epoch_unpin(Epoch_Thread *t) {
+    atomic_store_explicit(&t->local_epoch, 0, memory_order_release);
+}
+
+bool epoch_pool_try_advance(Epoch_Pool *ep) {
+    size_t epoch = atomic_load(&ep->global_epoch);
+    bool advanced;
+
+    pthread_mutex_lock(&ep->lock);
+    for(Epoch_Thread *t = ep->threads; t != NULL; t = t->next) {
+        size_t local = atomic_load(&t->local_epoch);
+        if((local & EPOCH_POOL_ACTIVE) && (local & ~EPOCH_POOL_ACTIVE) != epoch) {
+            // Someone is still reading in an older epoch
+            pthread_mutex_unlock(&ep->lock);
+            return false;
+        }
+    }
+
+    advanced = atomic_compare_exchange_strong(&ep->global_epoch, &epoch, epoch + 2);
+    pthread_mutex_unlock(&ep->lock);
+
+    return advanced;
+}
+
+// Blocks until everything retired before the call is safe to free, the caller must not be pinned
+void epoch_pool_synchronize(Epoch_Pool *ep) {
+    size_t start = atomic_load(&ep->global_epoch);
+
+    // Two advances, each epoch is stored shifted by one
+    while(atomic_load(&ep->global_epoch) - start < 2 * 2) {
+        if(!epoch_pool_try_advance(ep)) {
+            sched_yield();
+        }
+    }
+}
+
+void *epoch_pool_alloc(Epoch_Thread *t) {
+    Epoch_Pool *ep = t->ep;
+    void *ptr = NULL;
+
+    for(int attempt = 0; attempt < 2 && ptr == NULL; attempt++) {
+        if(attempt != 0) {
+            // The pool ran dry while chunks wait in limbo, so try to move the epoch along and reclaim them early
+            epoch_pool_try_advance(ep);
+            epoch_thread_collect(t, atomic_load(&ep->global_epoch));
+        }
+
+        pthread_mutex_lock(&ep->lock);
+        // Running dry is expected here, so it is not left to the pool's assert
+        ptr = ep->pool->head != NULL? pool_alloc(ep->pool) : NULL;
+        pthread_mutex_unlock(&ep->lock);
+    }
+
+    return ptr;
+}
+
+// The chunk has to be unlinked from the shared structure already, it is freed once no reader can still hold it
+void pool_retire(Epoch_Thread *t, void *ptr) {
+    Epoch_Bag *bag;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    assert((atomic_load(&t->local_epoch) & EPOCH_POOL_ACTIVE) && "Chunks must be retired while pinned");
+
+    // Readers may already be pinned in a newer epoch than this thread, so the chunk is tagged with the global one
+    epoch_thread_collect(t, atomic_load(&t->ep->global_epoch));
+    bag = &t->limbo[(t->seen_epoch >> 1) % EPOCH_POOL_BAGS];
+    if(bag->count == bag->capacity) {
+        void **ptrs = (void **)realloc(bag->ptrs, 2 * bag->capacity * sizeof(void *));
+        if(ptrs == NULL) {
+            assert(0 && "Epoch pool could not grow a limbo bag");
+            return;
+        }
+        bag->ptrs = ptrs;
+        bag->capacity *= 2;
+    }
+    bag->ptrs[bag->count++] = ptr;
+
+    if(bag->count % EPOCH_POOL_BATCH == 0) {
+        // The bags are only emptied on the next pin, which sees the advanced epoch
+        epoch_pool_try_advance(t->ep);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef EPOCH_POOL_H
+#define EPOCH_POOL_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of retired chunks in a bag after which the thread tries to advance the global epoch
+#ifndef EPOCH_POOL_BATCH
+#define EPOCH_POOL_BATCH 64
+#endif
+
+// Chunks retired in epoch e can still be seen by readers pinned in e and e+1, so three bags are enough
+#define EPOCH_POOL_BAGS 3
+
+// Set in a thread's local epoch while it is pinned
+#define EPOCH_POOL_ACTIVE ((size_t)1)
+
+typedef struct Epoch_Bag Epoch_Bag;
+struct Epoch_Bag {
+    void **ptrs;
+    size_t count;
+    size_t capacity;
+};
+
+typedef struct Epoch_Pool Epoch_Pool;
+typedef struct Epoch_Thread Epoch_Thread;
+
+// The C++ side only ever sees pointers, the layout uses C atomics
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+// One per thread, only the local epoch is ever read by other threads
+struct Epoch_Thread {
+    Epoch_Thread *next;
+    Epoch_Pool *ep;
+
+    _Atomic size_t local_epoch;
+    size_t seen_epoch;
+    Epoch_Bag limbo[EPOCH_POOL_BAGS];
+};
+
+struct Epoch_Pool {
+    Pool *pool;
+
+    // Guards the pool and the thread registry, readers never take it
+    pthread_mutex_t lock;
+    Epoch_Thread *threads;
+
+    _Atomic size_t global_epoch;
+};
+#endif
+
+void epoch_pool_init(Epoch_Pool *ep, Pool *pool);
+void epoch_pool_destroy(Epoch_Pool *ep);
+
+bool epoch_thread_register(Epoch_Pool *ep, Epoch_Thread *t);
+void epoch_thread_unregister(Epoch_Thread *t);
+
+void epoch_pin(Epoch_Thread *t);
+void epoch_unpin(Epoch_Thread *t);
+void epoch_thread_collect(Epoch_Thread *t, size_t epoch);
+bool epoch_pool_try_advance(Epoch_Pool *ep);
+void epoch_pool_synchronize(Epoch_Pool *ep);
+void epoch_bag_release(Epoch_Pool *ep, Epoch_Bag *bag);
+
+void *epoch_pool_alloc(Epoch_Thread *t);
+void pool_retire(Epoch_Thread *t, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,273 @@
+#include "frame_pool.h"
+
+#define FRAME_POOL_MAX_CHUNK ((size_t)FRAME_POOL_MIN_CHUNK << (FRAME_POOL_BUCKET_COUNT - 1))
+
+_Static_assert(sizeof(Frame_Header) % DEFAULT_ALIGNMENT == 0, "Frame header breaks the frame alignment");
+_Static_assert(IS_POWER_OF_TWO(FRAME_POOL_MIN_CHUNK), "Frame pool chunk sizes must be powers of two");
+
+// Remote frees link frames through their payload, which is why every payload holds at least a pointer
+#define frame_header_link(header) (*(Frame_Header **)((header) + 1))
+
+static _Thread_local Frame_Heap *frame_heap_tls = NULL;
+
+// Heaps of exited threads, the next new thread adopts one instead of creating its own
+static pthread_mutex_t frame_heap_orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+static Frame_Heap *frame_heap_orphans = NULL;
+static pthread_once_t frame_heap_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t frame_heap_key;
+
+size_t frame_pool_bucket_index(size_t total) {
+    if(total <= FRAME_POOL_MIN_CHUNK) {
+        return 0;
+    }
+    return (size_t)(64 - __builtin_clzll((unsigned long long)(total - 1)) - __builtin_ctz(FRAME_POOL_MIN_CHUNK));
+}
+
+bool frame_heap_init(Frame_Heap *h) {
+    size_t memory_size = FRAME_POOL_BUCKET_COUNT * FRAME_POOL_BUCKET_SIZE + FRAME_POOL_STACK_SIZE;
+
+    h->memory = (unsigned char *)malloc(memory_size);
+    if(h->memory == NULL) {
+        return false;
+    }
+
+    for(size_t i = 0; i < FRAME_POOL_BUCKET_COUNT; i++) {
+        pool_init(&h->buckets[i], h->memory + i * FRAME_POOL_BUCKET_SIZE, FRAME_POOL_BUCKET_SIZE,
+                  (size_t)FRAME_POOL_MIN_CHUNK << i, DEFAULT_ALIGNMENT);
+    }
+    stack_init(&h->stack, h->memory + FRAME_POOL_BUCKET_COUNT * FRAME_POOL_BUCKET_SIZE, FRAME_POOL_STACK_SIZE);
+    h->stack_top = NULL;
+
+    atomic_init(&h->remote, NULL);
+    atomic_init(&h->flush_wanted, false);
+
+    h->pending_owner = NULL;
+    h->pending_head = NULL;
+    h->pending_tail = NULL;
+    h->pending_count = 0;
+    h->next_orphan = NULL;
+
+    return true;
+}
+
+// Every frame of h has to be freed and every other thread has to have flushed its frames of h
+void frame_heap_destroy(Frame_Heap *h) {
+    frame_heap_flush_remote(h);
+    free(h->memory);
+    h->memory = NULL;
+}
+
+void frame_heap_thread_exit(void *arg) {
+    Frame_Heap *h = (Frame_Heap *)arg;
+
+    frame_heap_flush_remote(h);
+
+    pthread_mutex_lock(&frame_heap_orphans_lock);
+    h->next_orphan = frame_heap_orphans;
+    frame_heap_orphans = h;
+    pthread_mutex_unlock(&frame_heap_orphans_lock);
+}
+
+void frame_heap_key_create(void) {
+    pthread_key_create(&frame_heap_key, frame_heap_thread_exit);
+}
+
+// Frames can outlive the thread that allocated them, so the heap of an exited thread is never destroyed. Other
+// threads can still hand frames back to it, and the next thread that needs a heap takes it over.
+Frame_Heap *frame_heap_thread(void) {
+    if(frame_heap_tls == NULL) {
+        Frame_Heap *h;
+
+        pthread_once(&frame_heap_key_once, frame_heap_key_create);
+
+        pthread_mutex_lock(&frame_heap_orphans_lock);
+        h = frame_heap_orphans;
+        if(h != NULL) {
+            frame_heap_orphans = h->next_orphan;
+        }
+        pthread_mutex_unlock(&frame_heap_orphans_lock);
+
+        if(h == NULL) {
+            h = (Frame_Heap *)malloc(sizeof(Frame_Heap));
+            if(h != NULL && !frame_heap_init(h)) {
+                free(h);
+                h = NULL;
+            }
+        }
+
+        if(h != NULL) {
+            pthread_setspecific(frame_heap_key, h);
+        }
+        frame_heap_tls = h;
+    }
+    return frame_heap_tls;
+}
+
+void frame_heap_push_remote(Frame_Heap *owner, Frame_Header *first, Frame_Header *last) {
+    Frame_Header *head = atomic_load_explicit(&owner->remote, memory_order_relaxed);
+
+    do {
+        frame_header_link(last) = head;
+    } while(!atomic_compare_exchange_weak_explicit(&owner->remote, &head, first,
+                                                   memory_order_release, memory_order_relaxed));
+}
+
+void frame_heap_flush_remote(Frame_Heap *h) {
+    if(h->pending_head != NULL) {
+        frame_heap_push_remote(h->pending_owner, h->pending_head, h->pending_tail);
+        atomic_store_explicit(&h->pending_owner->flush_wanted, false, memory_order_relaxed);
+    }
+
+    h->pending_owner = NULL;
+    h->pending_head = NULL;
+    h->pending_tail = NULL;
+    h->pending_count = 0;
+}
+
+// A partial batch would otherwise wait for 32 frees or the exit of this thread, while its owner may already be out of
+// frames. The flag is a plain load that only changes when the owner runs dry.
+void frame_heap_flush_if_wanted(Frame_Heap *h) {
+    if(h->pending_head != NULL && atomic_load_explicit(&h->pending_owner->flush_wanted, memory_order_relaxed)) {
+        frame_heap_flush_remote(h);
+    }
+}
+
+// Takes the whole remote list with one exchange and frees it locally
+void frame_heap_drain_remote(Frame_Heap *h) {
+    Frame_Header *header = atomic_exchange_explicit(&h->remote, NULL, memory_order_acquire);
+
+    while(header != NULL) {
+        Frame_Header *next = frame_header_link(header);
+        frame_heap_release(h, header);
+        header = next;
+    }
+}
+
+void frame_heap_release(Frame_Heap *h, Frame_Header *header) {
+    if(header->kind < FRAME_STACK) {
+        pool_free(&h->buckets[header->kind], header);
+        return;
+    }
+
+    // Frames of strictly nested awaits come back in LIFO order and pop right away. One that finishes early stays
+    // marked until the frames above it are gone.
+    header->freed = 1;
+    while(h->stack_top != NULL && h->stack_top->freed) {
+        Frame_Header *top = h->stack_top;
+        h->stack_top = top->prev;
+        stack_free(&h->stack, top);
+    }
+}
+
+void *frame_alloc(Frame_Heap *h, size_t size) {
+    Frame_Header *header = NULL;
+    size_t total;
+    uint32_t kind = FRAME_MALLOC;
+    bool drained = false;
+
+    if(size < sizeof(Frame_Header *)) {
+        size = sizeof(Frame_Header *);
+    }
+    total = size + sizeof(Frame_Header);
+
+    if(h != NULL) {
+        frame_heap_flush_if_wanted(h);
+
+        if(total <= FRAME_POOL_MAX_CHUNK) {
+            size_t i = frame_pool_bucket_index(total);
+            Pool *p = &h->buckets[i];
+
+            if(p->head == NULL) {
+                frame_heap_drain_remote(h);
+                drained = true;
+                if(p->head == NULL) {
+                    // Asks for the batches still pending on other threads, they come in with the next drain
+                    atomic_store_explicit(&h->flush_wanted, true, memory_order_relaxed);
+                }
+            }
+
+            // The coroutine initializes its whole frame, so the chunk is not zeroed like pool_alloc would
+            if(p->head != NULL) {
+                header = (Frame_Header *)p->head;
+                p->head = p->head->next;
+                kind = (uint32_t)i;
+            }
+        }
+
+        if(header == NULL) {
+            header = (Frame_Header *)stack_alloc(&h->stack, total);
+            if(header == NULL && !drained) {
+                // Frames freed by other threads can be all that keeps the stack from popping
+                frame_heap_drain_remote(h);
+                header = (Frame_Header *)stack_alloc(&h->stack, total);
+            }
+            if(header != NULL) {
+                header->prev = h->stack_top;
+                h->stack_top = header;
+                kind = FRAME_STACK;
+            } else {
+                atomic_store_explicit(&h->flush_wanted, true, memory_order_relaxed);
+            }
+        }
+    }
+
+    if(header == NULL) {
+        header = (Frame_Header *)malloc(total);
+        if(header == NULL) {
+            return NULL;
+        }
+    }
+
+    header->owner = h;
+    header->size = size;
+    header->kind = kind;
+    header->freed = 0;
+
+    return header + 1;
+}
+
+// h is the heap of the calling thread, frames of other heaps are batched and handed back to their owner
+void frame_free(Frame_Heap *h, void *ptr) {
+    Frame_Header *header;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    header = (Frame_Header *)ptr - 1;
+
+    if(header->kind == FRAME_MALLOC) {
+        free(header);
+        return;
+    }
+
+    if(header->owner == h) {
+        frame_heap_release(h, header);
+        return;
+    }
+
+    if(h == NULL) {
+        frame_heap_push_remote(header->owner, header, header);
+        return;
+    }
+
+    if(h->pending_owner != header->owner) {
+        frame_heap_flush_remote(h);
+        h->pending_owner = header->owner;
+    }
+
+    frame_header_link(header) = NULL;
+    if(h->pending_tail == NULL) {
+        h->pending_head = header;
+    } else {
+        frame_header_link(h->pending_tail) = header;
+    }
+    h->pending_tail = header;
+
+    h->pending_count++;
+    if(h->pending_count >= FRAME_POOL_REMOTE_BATCH) {
+        frame_heap_flush_remote(h);
+    } else {
+        frame_heap_flush_if_wanted(h);
+    }
+}
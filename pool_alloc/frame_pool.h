@@ -0,0 +1,120 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "pool_alloc.h"
+#include "../stack_alloc/stack_alloc.h"
+
+// Frames up to FRAME_POOL_MIN_CHUNK << (FRAME_POOL_BUCKET_COUNT - 1) bytes, header included, come from the buckets
+#ifndef FRAME_POOL_BUCKET_COUNT
+#define FRAME_POOL_BUCKET_COUNT 6
+#endif
+
+#ifndef FRAME_POOL_MIN_CHUNK
+#define FRAME_POOL_MIN_CHUNK 64
+#endif
+
+#ifndef FRAME_POOL_BUCKET_SIZE
+#define FRAME_POOL_BUCKET_SIZE (64*1024)
+#endif
+
+#ifndef FRAME_POOL_STACK_SIZE
+#define FRAME_POOL_STACK_SIZE (256*1024)
+#endif
+
+// Frames freed by other threads are handed to their owner in chains of up to this many
+#ifndef FRAME_POOL_REMOTE_BATCH
+#define FRAME_POOL_REMOTE_BATCH 32
+#endif
+
+enum Frame_Kind { FRAME_STACK = FRAME_POOL_BUCKET_COUNT, FRAME_MALLOC };
+
+typedef struct Frame_Heap Frame_Heap;
+typedef struct Frame_Header Frame_Header;
+
+// The header stays a multiple of DEFAULT_ALIGNMENT, so frames keep the alignment of operator new
+struct Frame_Header {
+    Frame_Heap *owner;
+    // Stack frames link to the frame below them
+    Frame_Header *prev;
+    size_t size;
+    uint32_t kind;
+    uint32_t freed;
+};
+
+// The C++ side only ever sees a pointer, the layout uses C atomics
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+// One per thread. Only the owner touches the buckets and the stack, other threads only push onto remote.
+struct Frame_Heap {
+    unsigned char *memory;
+    Pool buckets[FRAME_POOL_BUCKET_COUNT];
+    Stack stack;
+    Frame_Header *stack_top;
+
+    _Atomic(Frame_Header *) remote;
+    // Set by the owner when it runs dry, threads holding a pending batch for it send it off on their next call
+    _Atomic bool flush_wanted;
+
+    // Frames this thread freed for pending_owner, linked through their payload
+    Frame_Heap *pending_owner;
+    Frame_Header *pending_head;
+    Frame_Header *pending_tail;
+    size_t pending_count;
+
+    Frame_Heap *next_orphan;
+};
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool frame_heap_init(Frame_Heap *h);
+void frame_heap_destroy(Frame_Heap *h);
+void frame_heap_thread_exit(void *arg);
+void frame_heap_key_create(void);
+Frame_Heap *frame_heap_thread(void);
+
+size_t frame_pool_bucket_index(size_t total);
+void frame_heap_push_remote(Frame_Heap *owner, Frame_Header *first, Frame_Header *last);
+void frame_heap_flush_remote(Frame_Heap *h);
+void frame_heap_flush_if_wanted(Frame_Heap *h);
+void frame_heap_drain_remote(Frame_Heap *h);
+void frame_heap_release(Frame_Heap *h, Frame_Header *header);
+
+void *frame_alloc(Frame_Heap *h, size_t size);
+void frame_free(Frame_Heap *h, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+#include <cstddef>
+#include <new>
+
+#include "frame_pool.h"
+
+// Inherit the promise type from this and the coroutine frames come from the frame heap of the calling thread:
+//
+//     struct promise_type : Frame_Pool_Promise { ... };
+//
+// A frame that ends on another thread is handed back to the thread that created it. That thread picks them up once
+// a bucket runs dry, frame_heap_flush_remote(frame_heap_thread()) sends the last partial batch off early.
+struct Frame_Pool_Promise {
+    static void *operator new(std::size_t size) {
+        void *ptr = frame_alloc(frame_heap_thread(), size);
+
+        if(ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    static void operator delete(void *ptr, std::size_t) noexcept {
+        frame_free(frame_heap_thread(), ptr);
+    }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "index_pool.h"
+
+_Static_assert(INDEX_POOL_GENERATION_BITS >= INDEX_POOL_MIN_GENERATION_BITS, "Index pool generations are too narrow");
+_Static_assert(INDEX_POOL_GENERATION_BITS <= 16, "Index pool generations are stored in 16 bits");
+
+Pool_Handle index_pool_make_handle(uint32_t index, uint16_t generation) {
+    return ((uint32_t)generation << INDEX_POOL_INDEX_BITS) | index;
+}
+
+uint32_t index_pool_handle_index(Pool_Handle h) {
+    return h & INDEX_POOL_INDEX_MASK;
+}
+
+uint16_t index_pool_handle_generation(Pool_Handle h) {
+    return (uint16_t)(h >> INDEX_POOL_INDEX_BITS);
+}
+
+Pool_Handle index_pool_alloc(Index_Pool *ip) {
+    uint32_t index = ip->head;
+    unsigned char *chunk;
+
+    if(index == INDEX_POOL_END) {
+        assert(0 && "Index pool allocator has no free memory");
+        return INDEX_POOL_NULL;
+    }
+
+    chunk = &ip->buf[(size_t)index * ip->chunk_size];
+    memcpy(&ip->head, chunk, sizeof(uint32_t));
+    memset(chunk, 0, ip->chunk_size);
+
+    return index_pool_make_handle(index, ip->generations[index]);
+}
+
+void index_pool_free(Index_Pool *ip, Pool_Handle h) {
+    uint32_t index;
+
+    if(h == INDEX_POOL_NULL) {
+        return;
+    }
+
+    if(!index_pool_is_valid(ip, h)) {
+        assert(0 && "Stale or invalid handle passed to index pool (free)");
+        return;
+    }
+
+    index = index_pool_handle_index(h);
+    if(!index_pool_bump_generation(ip, index)) {
+        return;
+    }
+
+    memcpy(&ip->buf[(size_t)index * ip->chunk_size], &ip->head, sizeof(uint32_t));
+    ip->head = index;
+}
+
+// Every handle to the chunk goes stale. A generation that would wrap around retires the chunk instead, since a stale
+// handle would match again. Returns false for a retired chunk, which never goes back on the free list.
+bool index_pool_bump_generation(Index_Pool *ip, uint32_t index) {
+    uint32_t generation = (uint32_t)ip->generations[index];
+
+    if(generation == INDEX_POOL_RETIRED || generation == INDEX_POOL_GENERATION_MAX) {
+        ip->generations[index] = INDEX_POOL_RETIRED;
+        return false;
+    }
+
+    ip->generations[index] = (uint16_t)(generation + 1);
+    return true;
+}
+
+void index_pool_free_all(Index_Pool *ip) {
+    ip->head = INDEX_POOL_END;
+
+    // Pushed backwards, so the chunks are handed out in address order again
+    for(uint32_t i = ip->chunk_count; i > 0; i--) {
+        uint32_t index = i - 1;
+
+        if(index_pool_bump_generation(ip, index)) {
+            memcpy(&ip->buf[(size_t)index * ip->chunk_size], &ip->head, sizeof(uint32_t));
+            ip->head = index;
+        }
+    }
+}
+
+void index_pool_init(Index_Pool *ip, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment) {
+    uintptr_t initial_start = (uintptr_t)backing_buffer;
+    uintptr_t start = align_forward_uinptr(initial_start, (uintptr_t)chunk_alignment);
+    size_t chunk_count;
+
+    assert(backing_buffer_length >= (size_t)(start - initial_start) && "Backing buffer is too small to be aligned.");
+    backing_buffer_length -= (size_t)(start - initial_start);
+
+    chunk_size = align_forward_size(chunk_size, chunk_alignment);
+    assert(chunk_size >= sizeof(uint32_t) && "Chunk size is too small.");
+
+    // Every chunk also needs its generation at the end of the buffer, the extra one leaves room to align them
+    chunk_count = backing_buffer_length / (chunk_size + sizeof(uint16_t));
+    if(chunk_count != 0 && chunk_count * (chunk_size + sizeof(uint16_t)) + sizeof(uint16_t) > backing_buffer_length) {
+        chunk_count--;
+    }
+    if(chunk_count > INDEX_POOL_END) {
+        // Handles can't reach the rest of the buffer, a larger pool needs a larger INDEX_POOL_INDEX_BITS
+        assert(0 && "Backing buffer holds more chunks than index pool handles can address.");
+        chunk_count = INDEX_POOL_END;
+    }
+    assert(chunk_count != 0 && "Backing buffer length is smaller than the actual size.");
+
+    ip->buf = (unsigned char *)start;
+    ip->chunk_size = chunk_size;
+    ip->chunk_count = (uint32_t)chunk_count;
+    ip->generations = (uint16_t *)ALIGN_BACKWARD(start + backing_buffer_length - chunk_count * sizeof(uint16_t),
+                                                 (uintptr_t)_Alignof(uint16_t));
+
+    // Chunks start out at generation 1 and are handed out in address order
+    ip->head = INDEX_POOL_END;
+    for(size_t i = chunk_count; i > 0; i--) {
+        ip->generations[i - 1] = 1;
+        memcpy(&ip->buf[(i - 1) * chunk_size], &ip->head, sizeof(uint32_t));
+        ip->head = (uint32_t)(i - 1);
+    }
+}
+
+bool index_pool_is_valid(Index_Pool *ip, Pool_Handle h) {
+    uint32_t index = index_pool_handle_index(h);
+
+    return h != INDEX_POOL_NULL && index < ip->chunk_count && ip->generations[index] != INDEX_POOL_RETIRED &&
+           ip->generations[index] == index_pool_handle_generation(h);
+}
+
+// Stale handles resolve to NULL, a live one is a single multiply-add away from its chunk
+void *index_pool_resolve(Index_Pool *ip, Pool_Handle h) {
+    if(!index_pool_is_valid(ip, h)) {
+        return NULL;
+    }
+
+    return &ip->buf[(size_t)index_pool_handle_index(h) * ip->chunk_size];
+}
+
+Pool_Handle index_pool_handle_of(Index_Pool *ip, void *ptr) {
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)ip->buf;
+    uint32_t index;
+
+    if(ptr == NULL) {
+        return INDEX_POOL_NULL;
+    }
+
+    if(!((uintptr_t)ip->buf <= (uintptr_t)ptr && offset < (uintptr_t)ip->chunk_count * ip->chunk_size)) {
+        assert(0 && "Memory is out of bounds of the buffer in this index pool");
+        return INDEX_POOL_NULL;
+    }
+
+    index = (uint32_t)(offset / ip->chunk_size);
+    return index_pool_make_handle(index, ip->generations[index]);
+}
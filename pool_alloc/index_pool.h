@@ -0,0 +1,89 @@
+#ifndef INDEX_POOL_H
+#define INDEX_POOL_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include "pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A handle is the chunk index in the low bits and the chunk generation in the high bits. The default splits them 16/16,
+// which caps a pool at 65535 chunks. Pools of millions of nodes take more index bits, up to 24, which leaves 8 bits of
+// generation. A chunk is retired instead of wrapping its generation, so fewer bits mean chunks are retired sooner.
+#ifndef INDEX_POOL_INDEX_BITS
+#define INDEX_POOL_INDEX_BITS 16
+#endif
+
+#define INDEX_POOL_INDEX_MASK (((uint32_t)1 << INDEX_POOL_INDEX_BITS) - 1)
+#define INDEX_POOL_GENERATION_BITS (32 - INDEX_POOL_INDEX_BITS)
+#define INDEX_POOL_GENERATION_MAX (((uint32_t)1 << INDEX_POOL_GENERATION_BITS) - 1)
+
+// With fewer bits a chunk that is reused often would be retired after a handful of frees
+#define INDEX_POOL_MIN_GENERATION_BITS 8
+
+// Live generations start at 1, so no valid handle is ever 0. A retired chunk keeps generation 0 and never validates.
+#define INDEX_POOL_NULL ((Pool_Handle)0)
+#define INDEX_POOL_RETIRED 0
+
+// Terminates the free list, which is why the last index can't be used for a chunk
+#define INDEX_POOL_END INDEX_POOL_INDEX_MASK
+
+typedef uint32_t Pool_Handle;
+
+typedef struct Index_Pool Index_Pool;
+struct Index_Pool {
+    unsigned char *buf;
+    size_t chunk_size;
+    uint32_t chunk_count;
+
+    // Free chunks link to each other by index instead of by pointer
+    uint32_t head;
+
+    // Two bytes per chunk, carved from the end of the backing buffer
+    uint16_t *generations;
+};
+
+Pool_Handle index_pool_make_handle(uint32_t index, uint16_t generation);
+uint32_t index_pool_handle_index(Pool_Handle h);
+uint16_t index_pool_handle_generation(Pool_Handle h);
+bool index_pool_bump_generation(Index_Pool *ip, uint32_t index);
+
+Pool_Handle index_pool_alloc(Index_Pool *ip);
+void index_pool_free(Index_Pool *ip, Pool_Handle h);
+void index_pool_free_all(Index_Pool *ip);
+void index_pool_init(Index_Pool *ip, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment);
+
+bool index_pool_is_valid(Index_Pool *ip, Pool_Handle h);
+void *index_pool_resolve(Index_Pool *ip, Pool_Handle h);
+Pool_Handle index_pool_handle_of(Index_Pool *ip, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+#include "magazine_alloc.h"
+
+Magazine *magazine_create(size_t capacity) {
+    Magazine *m = (Magazine *)malloc(sizeof(Magazine) + capacity * sizeof(void *));
+
+    if(m != NULL) {
+        m->next = NULL;
+        m->capacity = capacity;
+        m->rounds = 0;
+    }
+
+    return m;
+}
+
+void magazine_depot_lock(Magazine_Depot *d) {
+    if(pthread_mutex_trylock(&d->lock) != 0) {
+        pthread_mutex_lock(&d->lock);
+
+        // The depot is contended, so bigger magazines are used to visit it less often
+        d->contention++;
+        if(d->contention >= MAGAZINE_CONTENTION_LIMIT) {
+            d->contention = 0;
+            if(d->magazine_size < MAGAZINE_MAX_ROUNDS) {
+                d->magazine_size <<= 1;
+            }
+        }
+    }
+}
+
+Magazine *magazine_depot_take_empty(Magazine_Depot *d) {
+    Magazine *m = d->empty;
+
+    while(m != NULL && m->capacity < d->magazine_size) {
+        // Retire magazines which are smaller than the current size
+        d->empty = m->next;
+        free(m);
+        m = d->empty;
+    }
+
+    if(m != NULL) {
+        d->empty = m->next;
+        m->next = NULL;
+        return m;
+    }
+
+    return magazine_create(d->magazine_size);
+}
+
+void magazine_depot_init(Magazine_Depot *d, Pool *pool) {
+    d->pool = pool;
+    pthread_mutex_init(&d->lock, NULL);
+    d->full = NULL;
+    d->empty = NULL;
+    d->magazine_size = MAGAZINE_MIN_ROUNDS;
+    d->contention = 0;
+}
+
+void magazine_depot_destroy(Magazine_Depot *d) {
+    Magazine *m;
+
+    while(d->full != NULL) {
+        m = d->full;
+        d->full = m->next;
+        pool_free_bulk(d->pool, m->round, m->rounds);
+        free(m);
+    }
+
+    while(d->empty != NULL) {
+        m = d->empty;
+        d->empty = m->next;
+        free(m);
+    }
+
+    pthread_mutex_destroy(&d->lock);
+}
+
+bool magazine_cache_init(Magazine_Cache *c, Magazine_Depot *d) {
+    c->depot = d;
+
+    magazine_depot_lock(d);
+    c->loaded = magazine_depot_take_empty(d);
+    c->previous = magazine_depot_take_empty(d);
+    pthread_mutex_unlock(&d->lock);
+
+    if(c->loaded == NULL || c->previous == NULL) {
+        free(c->loaded);
+        free(c->previous);
+        c->loaded = NULL;
+        c->previous = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void magazine_cache_flush(Magazine_Cache *c) {
+    Magazine_Depot *d = c->depot;
+    Magazine *mags[2] = { c->loaded, c->previous };
+
+    magazine_depot_lock(d);
+    for(size_t i = 0; i < 2; i++) {
+        Magazine *m = mags[i];
+
+        if(m == NULL) {
+            continue;
+        }
+
+        if(m->rounds == m->capacity) {
+            m->next = d->full;
+            d->full = m;
+        } else {
+            // Only full magazines live in the depot, partial ones go back to the pool
+            pool_free_bulk(d->pool, m->round, m->rounds);
+            m->rounds = 0;
+            m->next = d->empty;
+            d->empty = m;
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    c->loaded = NULL;
+    c->previous = NULL;
+}
+
+void *magazine_alloc(Magazine_Cache *c) {
+    Magazine_Depot *d = c->depot;
+    void *ptr;
+
+    if(c->loaded->rounds == 0) {
+        if(c->previous->rounds > 0) {
+            Magazine *tmp = c->loaded;
+            c->loaded = c->previous;
+            c->previous = tmp;
+        } else {
+            magazine_depot_lock(d);
+            if(d->full != NULL) {
+                // Both magazines are empty, hand one back and load a full one
+                Magazine *full = d->full;
+                d->full = full->next;
+
+                c->previous->next = d->empty;
+                d->empty = c->previous;
+
+                c->previous = c->loaded;
+                c->loaded = full;
+                c->loaded->next = NULL;
+            } else {
+                // Freed rounds go back into magazines as they are, so every round is zeroed on alloc and not here
+                c->loaded->rounds = pool_take_bulk(d->pool, c->loaded->round, c->loaded->capacity);
+            }
+            pthread_mutex_unlock(&d->lock);
+
+            if(c->loaded->rounds == 0) {
+                assert(0 && "Magazine depot has no free memory");
+                return NULL;
+            }
+        }
+    }
+
+    ptr = c->loaded->round[--c->loaded->rounds];
+
+    return memset(ptr, 0, d->pool->chunk_size);
+}
+
+void magazine_free(Magazine_Cache *c, void *ptr) {
+    Magazine_Depot *d = c->depot;
+
+    void *start = d->pool->buf;
+    void *end = &d->pool->buf[d->pool->buf_len];
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    if(!(start <= ptr && ptr < end)) {
+        assert(0 && "Memory is out of bounds of the buffer in this pool");
+        return;
+    }
+
+    if(c->loaded->rounds == c->loaded->capacity) {
+        if(c->previous->rounds == 0) {
+            Magazine *tmp = c->loaded;
+            c->loaded = c->previous;
+            c->previous = tmp;
+        } else {
+            Magazine *empty;
+
+            magazine_depot_lock(d);
+            empty = magazine_depot_take_empty(d);
+            if(empty == NULL) {
+                // No memory for a new magazine, skip the cache
+                pool_free(d->pool, ptr);
+                pthread_mutex_unlock(&d->lock);
+                return;
+            }
+
+            // Both magazines are full, hand one to the depot so other threads can reuse it
+            c->previous->next = d->full;
+            d->full = c->previous;
+
+            c->previous = c->loaded;
+            c->loaded = empty;
+            pthread_mutex_unlock(&d->lock);
+        }
+    }
+
+    c->loaded->round[c->loaded->rounds++] = ptr;
+}
@@ -0,0 +1,94 @@
+#ifndef MAGAZINE_ALLOC_H
+#define MAGAZINE_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MAGAZINE_MIN_ROUNDS
+#define MAGAZINE_MIN_ROUNDS 8
+#endif
+
+#ifndef MAGAZINE_MAX_ROUNDS
+#define MAGAZINE_MAX_ROUNDS 256
+#endif
+
+// Number of contended depot lock acquisitions before the magazine size is doubled
+#ifndef MAGAZINE_CONTENTION_LIMIT
+#define MAGAZINE_CONTENTION_LIMIT 16
+#endif
+
+typedef struct Magazine Magazine;
+struct Magazine {
+    Magazine *next;
+    size_t capacity;
+    size_t rounds;
+    void *round[];
+};
+
+typedef struct Magazine_Depot Magazine_Depot;
+struct Magazine_Depot {
+    Pool *pool;
+    pthread_mutex_t lock;
+
+    Magazine *full;
+    Magazine *empty;
+
+    size_t magazine_size;
+    size_t contention;
+};
+
+// One per thread, it is never shared so alloc and free need no synchronization until the depot is hit
+typedef struct Magazine_Cache Magazine_Cache;
+struct Magazine_Cache {
+    Magazine_Depot *depot;
+    Magazine *loaded;
+    Magazine *previous;
+};
+
+Magazine *magazine_create(size_t capacity);
+void magazine_depot_lock(Magazine_Depot *d);
+Magazine *magazine_depot_take_empty(Magazine_Depot *d);
+
+void magazine_depot_init(Magazine_Depot *d, Pool *pool);
+void magazine_depot_destroy(Magazine_Depot *d);
+
+bool magazine_cache_init(Magazine_Cache *c, Magazine_Depot *d);
+void magazine_cache_flush(Magazine_Cache *c);
+void *magazine_alloc(Magazine_Cache *c);
+void magazine_free(Magazine_Cache *c, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
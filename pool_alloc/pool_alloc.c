@@ -1,41 +1,5 @@
 #include "pool_alloc.h"
 
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-uintptr_t align_forward_uinptr(uintptr_t ptr, uintptr_t align) {
-    uintptr_t a, p, modulo;
-
-    assert(is_power_of_two(align));
-
-    a = align;
-    p = ptr;
-    modulo = p & (a-1);
-
-    if(modulo != 0) {
-        p += a - modulo;
-    }
-
-    return p;
-}
-
-size_t align_forward_size(size_t ptr, size_t align) {
-    size_t a, p, modulo;
-
-    assert(is_power_of_two((uintptr_t)align));
-
-    a = align;
-    p = ptr;
-    modulo = p & (a-1);
-
-    if(modulo != 0) {
-        p += a - modulo;
-    }
-
-    return p;
-}
-
 void *pool_alloc(Pool *p) {
     Pool_Free_Node *node = p->head;
 
@@ -69,18 +33,132 @@ void pool_free(Pool *p, void *ptr) {
     p->head = node;
 }
 
+// Pops up to n chunks without zeroing them, for callers that zero or initialize the chunks themselves
+size_t pool_take_bulk(Pool *p, void **out, size_t n) {
+    Pool_Free_Node *node = p->head;
+    size_t count = 0;
+
+    // Walk the chain once. Every next pointer is a dependent load, the address of a node is only known once the node
+    // before it has been read, so there is nothing to prefetch ahead of the walk.
+    while(count < n && node != NULL) {
+        out[count++] = node;
+        node = node->next;
+    }
+
+    p->head = node;
+
+    return count;
+}
+
+size_t pool_alloc_bulk(Pool *p, void **out, size_t n) {
+    unsigned char *run_start, *run_end;
+    size_t count = pool_take_bulk(p, out, n);
+
+    if(count == 0) {
+        return 0;
+    }
+
+    // Zero adjacent chunks with a single memset, after pool_free_all the chain runs backwards through the buffer
+    run_start = (unsigned char *)out[0];
+    run_end = run_start + p->chunk_size;
+    for(size_t i = 1; i < count; i++) {
+        unsigned char *chunk = (unsigned char *)out[i];
+
+        // The addresses are all known now, so chunks are fetched ahead of the memsets like in pool_free_bulk
+        if(i + POOL_PREFETCH_DISTANCE < count) {
+            __builtin_prefetch(out[i + POOL_PREFETCH_DISTANCE], 1);
+        }
+
+        if(chunk == run_end) {
+            run_end += p->chunk_size;
+        } else if(chunk + p->chunk_size == run_start) {
+            run_start = chunk;
+        } else {
+            memset(run_start, 0, (size_t)(run_end - run_start));
+            run_start = chunk;
+            run_end = chunk + p->chunk_size;
+        }
+    }
+    memset(run_start, 0, (size_t)(run_end - run_start));
+
+    return count;
+}
+
+void pool_free_bulk(Pool *p, void **ptrs, size_t n) {
+    Pool_Free_Node *first = NULL;
+    Pool_Free_Node *last = NULL;
+
+    void *start = p->buf;
+    void *end = &p->buf[p->buf_len];
+
+    for(size_t i = 0; i < n; i++) {
+        Pool_Free_Node *node;
+
+        if(i + POOL_PREFETCH_DISTANCE < n && ptrs[i + POOL_PREFETCH_DISTANCE] != NULL) {
+            __builtin_prefetch(ptrs[i + POOL_PREFETCH_DISTANCE], 1);
+        }
+
+        if(ptrs[i] == NULL) {
+            continue;
+        }
+
+        if(!(start <= ptrs[i] && ptrs[i] < end)) {
+            assert(0 && "Memory is out of bounds of the buffer in this pool");
+            continue;
+        }
+
+        // Link the batch into a sub-chain and splice it onto the head once
+        node = (Pool_Free_Node *)ptrs[i];
+        if(last == NULL) {
+            first = node;
+        } else {
+            last->next = node;
+        }
+        last = node;
+    }
+
+    if(last != NULL) {
+        last->next = p->head;
+        p->head = first;
+    }
+}
+
 void pool_free_all(Pool *p) {
-    size_t chunk_count = p->buf_len / p->chunk_size;
+    p->head = NULL;
+
+    if(p->slab_size == 0) {
+        size_t chunk_count = p->buf_len / p->chunk_size;
+
+        for (size_t i = 0; i < chunk_count; i++) {
+            void *ptr = &p->buf[i * p->chunk_size];
+            Pool_Free_Node *node = (Pool_Free_Node *) ptr;
+            node->next = p->head;
+            p->head = node;
+        }
+        return;
+    }
 
-    for (size_t i = 0; i < chunk_count; i++) {
-        void *ptr = &p->buf[i * p->chunk_size];
-        Pool_Free_Node *node = (Pool_Free_Node *) ptr;
-        node->next = p->head;
-        p->head = node;
+    for(size_t slab = 0; slab * p->slab_size < p->buf_len; slab++) {
+        size_t slab_start = slab * p->slab_size;
+        size_t slab_end = p->buf_len - slab_start < p->slab_size? p->buf_len : slab_start + p->slab_size;
+
+        // The color of a slab moves its first chunk, so the same chunk of neighbouring slabs maps to other cache sets
+        for(size_t offset = slab_start + (slab % p->color_count) * p->color_step;
+            offset <= slab_end && p->chunk_size <= slab_end - offset; offset += p->chunk_size) {
+            Pool_Free_Node *node = (Pool_Free_Node *)&p->buf[offset];
+            node->next = p->head;
+            p->head = node;
+        }
     }
 }
 
 void pool_init(Pool *p, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment) {
+    pool_init_colored(p, backing_buffer, backing_buffer_length, chunk_size, chunk_alignment, 0, 0);
+}
+
+// A slab size of 0 turns coloring off, a color step of 0 uses CACHE_LINE_SIZE
+void pool_init_colored(Pool *p, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment,
+                       size_t slab_size, size_t color_step) {
     uintptr_t initial_start = (uintptr_t) backing_buffer;
     uintptr_t start = align_forward_uinptr(initial_start, (uintptr_t)chunk_alignment);
     backing_buffer_length -= (size_t)(start - initial_start);
@@ -90,10 +168,36 @@ void pool_init(Pool *p, void *backing_buffer, size_t backing_buffer_length, size
     assert(chunk_size >= sizeof(Pool_Free_Node) && "Chunk size is too small.");
     assert(backing_buffer_length >= chunk_size && "Backing buffer length is smaller than the actual size.");
 
-    p->buf = (unsigned char*)backing_buffer;
+    // The chunks start at the aligned address, the length was already shortened to match
+    p->buf = (unsigned char*)start;
     p->buf_len = backing_buffer_length;
     p->chunk_size = chunk_size;
     p->head = NULL;
 
+    p->slab_size = 0;
+    p->color_step = 0;
+    p->color_count = 1;
+
+    if(slab_size != 0) {
+        if(color_step == 0) {
+            color_step = CACHE_LINE_SIZE;
+        }
+        color_step = align_forward_size(color_step, chunk_alignment);
+        slab_size = align_forward_size(slab_size, chunk_alignment);
+
+        assert(slab_size >= chunk_size && "Slab size is smaller than the chunk size.");
+
+        // Colors use the slack at the end of a slab. Chunk sizes that divide the slab, the ones that conflict the most,
+        // leave none, so one chunk per slab is given up for it.
+        size_t chunks_per_slab = slab_size / chunk_size;
+        if(slab_size % chunk_size < color_step && chunks_per_slab > 1) {
+            chunks_per_slab--;
+        }
+
+        p->slab_size = slab_size;
+        p->color_step = color_step;
+        p->color_count = (slab_size - chunks_per_slab * chunk_size) / color_step + 1;
+    }
+
     pool_free_all(p);
 }
@@ -1,3 +1,6 @@
+#ifndef POOL_ALLOC_H
+#define POOL_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,10 +26,24 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+#ifndef POOL_PREFETCH_DISTANCE
+#define POOL_PREFETCH_DISTANCE 8
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
 typedef struct Pool_Free_Node Pool_Free_Node;
 struct Pool_Free_Node {
 	Pool_Free_Node *next;
@@ -38,15 +55,29 @@ struct Pool {
 	size_t buf_len;
 	size_t chunk_size;
 
+	// With a slab size, chunks are laid out per slab and every slab starts color_step bytes further in than the one
+	// before, cycling through color_count offsets. A slab size of 0 lays chunks out back to back.
+	size_t slab_size;
+	size_t color_step;
+	size_t color_count;
+
 	Pool_Free_Node *head;
 };
 
 
-bool is_power_of_two(uintptr_t x);
-uintptr_t align_forward_uinptr(uintptr_t ptr, uintptr_t align);
-size_t align_forward_size(size_t ptr, size_t align);
 
 void *pool_alloc(Pool *p);
 void pool_free(Pool *p, void *ptr);
+size_t pool_take_bulk(Pool *p, void **out, size_t n);
+size_t pool_alloc_bulk(Pool *p, void **out, size_t n);
+void pool_free_bulk(Pool *p, void **ptrs, size_t n);
 void pool_free_all(Pool *p);
 void pool_init(Pool *p, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment);
+void pool_init_colored(Pool *p, void *backing_buffer, size_t backing_buffer_length, size_t chunk_size, size_t chunk_alignment,
+                       size_t slab_size, size_t color_step);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
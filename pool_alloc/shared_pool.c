@@ -0,0 +1,127 @@
+#include "shared_pool.h"
+
+#include <errno.h>
+
+// A process that dies holding the lock hands it over as EOWNERDEAD. A pool operation is a single head update,
+// so the free list is consistent either way and the lock can be marked as usable again.
+void shared_pool_lock(Shared_Pool *sp) {
+    if(pthread_mutex_lock(&sp->lock) == EOWNERDEAD) {
+        pthread_mutex_consistent(&sp->lock);
+    }
+}
+
+Shared_Pool *shared_pool_init(void *region, size_t region_size, size_t chunk_size, size_t chunk_alignment) {
+    Shared_Pool *sp = (Shared_Pool *)region;
+    pthread_mutexattr_t attr;
+    size_t start;
+
+    assert(region_size >= sizeof(Shared_Pool) && "Shared region is smaller than the pool header.");
+
+    chunk_size = align_forward_size(chunk_size, chunk_alignment);
+    assert(chunk_size >= sizeof(Shared_Pool_Offset) && "Chunk size is too small.");
+
+    start = (size_t)(align_forward_uinptr((uintptr_t)region + sizeof(Shared_Pool), (uintptr_t)chunk_alignment) - (uintptr_t)region);
+    assert(region_size >= start + chunk_size && "Backing buffer length is smaller than the actual size.");
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&sp->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    sp->region_size = region_size;
+    sp->chunk_size = chunk_size;
+    sp->chunk_count = (region_size - start) / chunk_size;
+    sp->chunks = start;
+    sp->head = SHARED_POOL_NULL;
+
+    shared_pool_free_all(sp);
+
+    // Written last, so a process that attaches early never sees a half initialized pool
+    __atomic_store_n(&sp->magic, SHARED_POOL_MAGIC, __ATOMIC_RELEASE);
+
+    return sp;
+}
+
+Shared_Pool *shared_pool_attach(void *region) {
+    Shared_Pool *sp = (Shared_Pool *)region;
+
+    if(__atomic_load_n(&sp->magic, __ATOMIC_ACQUIRE) != SHARED_POOL_MAGIC) {
+        return NULL;
+    }
+
+    return sp;
+}
+
+void *shared_pool_alloc(Shared_Pool *sp) {
+    Shared_Pool_Offset offset;
+    unsigned char *chunk;
+
+    shared_pool_lock(sp);
+
+    offset = sp->head;
+    if(offset == SHARED_POOL_NULL) {
+        pthread_mutex_unlock(&sp->lock);
+        return NULL;
+    }
+
+    chunk = (unsigned char *)sp + offset;
+    memcpy(&sp->head, chunk, sizeof(Shared_Pool_Offset));
+
+    pthread_mutex_unlock(&sp->lock);
+
+    return memset(chunk, 0, sp->chunk_size);
+}
+
+void shared_pool_free(Shared_Pool *sp, void *ptr) {
+    Shared_Pool_Offset offset;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    offset = shared_pool_offset_of(sp, ptr);
+    if(offset < sp->chunks) {
+        assert(0 && "Memory is out of bounds of the buffer in this pool");
+        return;
+    }
+
+    shared_pool_lock(sp);
+    memcpy(ptr, &sp->head, sizeof(Shared_Pool_Offset));
+    sp->head = offset;
+    pthread_mutex_unlock(&sp->lock);
+}
+
+void shared_pool_free_all(Shared_Pool *sp) {
+    sp->head = SHARED_POOL_NULL;
+
+    for(size_t i = sp->chunk_count; i > 0; i--) {
+        Shared_Pool_Offset offset = sp->chunks + (i - 1) * sp->chunk_size;
+
+        memcpy((unsigned char *)sp + offset, &sp->head, sizeof(Shared_Pool_Offset));
+        sp->head = offset;
+    }
+}
+
+// Offsets are what gets sent to another process, which turns it back into a pointer in its own mapping
+Shared_Pool_Offset shared_pool_offset_of(Shared_Pool *sp, void *ptr) {
+    if(ptr == NULL) {
+        return SHARED_POOL_NULL;
+    }
+
+    if(!((unsigned char *)sp <= (unsigned char *)ptr && (unsigned char *)ptr < (unsigned char *)sp + sp->region_size)) {
+        assert(0 && "Memory is out of bounds of the buffer in this pool");
+        return SHARED_POOL_NULL;
+    }
+
+    return (Shared_Pool_Offset)((unsigned char *)ptr - (unsigned char *)sp);
+}
+
+void *shared_pool_ptr_of(Shared_Pool *sp, Shared_Pool_Offset offset) {
+    if(offset == SHARED_POOL_NULL) {
+        return NULL;
+    }
+
+    assert(offset < sp->region_size && "Offset is out of bounds of the buffer in this pool");
+    return (unsigned char *)sp + offset;
+}
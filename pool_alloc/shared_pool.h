@@ -0,0 +1,74 @@
+#ifndef SHARED_POOL_H
+#define SHARED_POOL_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "pool_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// "SHMPOOL1" read as a little-endian integer
+#define SHARED_POOL_MAGIC 0x314c4f4f504d4853ull
+
+// The pool itself sits at offset 0 of the region, so no chunk can ever be there
+#define SHARED_POOL_NULL ((Shared_Pool_Offset)0)
+
+typedef uint64_t Shared_Pool_Offset;
+
+// Lives at the start of the shared region, every link is an offset from it so each process can map it anywhere
+typedef struct Shared_Pool Shared_Pool;
+struct Shared_Pool {
+    uint64_t magic;
+    pthread_mutex_t lock;
+
+    size_t region_size;
+    size_t chunk_size;
+    size_t chunk_count;
+    Shared_Pool_Offset chunks;
+
+    Shared_Pool_Offset head;
+};
+
+void shared_pool_lock(Shared_Pool *sp);
+
+Shared_Pool *shared_pool_init(void *region, size_t region_size, size_t chunk_size, size_t chunk_alignment);
+Shared_Pool *shared_pool_attach(void *region);
+void *shared_pool_alloc(Shared_Pool *sp);
+void shared_pool_free(Shared_Pool *sp, void *ptr);
+void shared_pool_free_all(Shared_Pool *sp);
+
+Shared_Pool_Offset shared_pool_offset_of(Shared_Pool *sp, void *ptr);
+void *shared_pool_ptr_of(Shared_Pool *sp, Shared_Pool_Offset offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "ring_alloc.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+void ring_init(Ring *r, void *backing_buffer, size_t backing_buffer_length) {
+    assert(((uintptr_t)backing_buffer & (RING_ALIGNMENT - 1)) == 0 && "Ring buffer has to be aligned to RING_ALIGNMENT");
+
+    r->buf = (unsigned char *)backing_buffer;
+    // Records are whole alignment slots, so a buffer made of them never leaves a sliver at the end
+    r->buf_len = backing_buffer_length & ~(size_t)(RING_ALIGNMENT - 1);
+    r->head = 0;
+    r->tail = 0;
+    r->mirrored = false;
+}
+
+bool ring_init_mirrored(Ring *r, size_t size) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *base;
+    void *first, *second;
+    int fd;
+
+    size = (size + page_size - 1) & ~(page_size - 1);
+    if(size == 0) {
+        return false;
+    }
+
+    fd = memfd_create("ring_alloc", MFD_CLOEXEC);
+    if(fd < 0) {
+        return false;
+    }
+
+    if(ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // Reserve both halves first, so nothing else can be mapped in between them
+    base = (unsigned char *)mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    first = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    second = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+
+    if(first == MAP_FAILED || second == MAP_FAILED) {
+        munmap(base, 2 * size);
+        return false;
+    }
+
+    r->buf = base;
+    r->buf_len = size;
+    r->head = 0;
+    r->tail = 0;
+    r->mirrored = true;
+
+    return true;
+}
+
+void ring_destroy(Ring *r) {
+    if(r->mirrored) {
+        munmap(r->buf, 2 * r->buf_len);
+    }
+
+    r->buf = NULL;
+    r->buf_len = 0;
+    r->head = 0;
+    r->tail = 0;
+}
+
+void *ring_alloc(Ring *r, size_t size) {
+    size_t record, pos, skip = 0;
+    Ring_Record_Header *header;
+
+    if(size > r->buf_len) {
+        return NULL;
+    }
+
+    record = RING_ALIGNMENT + ((size + RING_ALIGNMENT - 1) & ~(size_t)(RING_ALIGNMENT - 1));
+    pos = r->head % r->buf_len;
+
+    // The mirror makes a record that crosses the end contiguous, otherwise the rest of the buffer is skipped
+    if(!r->mirrored && pos + record > r->buf_len) {
+        skip = r->buf_len - pos;
+    }
+
+    if(skip + record > ring_available(r)) {
+        return NULL;
+    }
+
+    if(skip != 0) {
+        header = (Ring_Record_Header *)&r->buf[pos];
+        header->size = skip | RING_SKIP;
+        r->head += skip;
+        pos = 0;
+    }
+
+    header = (Ring_Record_Header *)&r->buf[pos];
+    header->size = record;
+    r->head += record;
+
+    return memset(&r->buf[pos + RING_ALIGNMENT], 0, size);
+}
+
+// Returns the oldest live record, which is the only one that can be freed next
+void *ring_peek(Ring *r) {
+    Ring_Record_Header *header;
+    size_t pos;
+
+    while(r->tail != r->head) {
+        pos = r->tail % r->buf_len;
+
+        header = (Ring_Record_Header *)&r->buf[pos];
+        if(header->size & RING_SKIP) {
+            r->tail += header->size & ~RING_SKIP;
+            continue;
+        }
+
+        return &r->buf[pos + RING_ALIGNMENT];
+    }
+
+    return NULL;
+}
+
+size_t ring_record_size(void *ptr) {
+    Ring_Record_Header *header = (Ring_Record_Header *)((unsigned char *)ptr - RING_ALIGNMENT);
+
+    return header->size - RING_ALIGNMENT;
+}
+
+size_t ring_available(Ring *r) {
+    return r->buf_len - (r->head - r->tail);
+}
+
+void ring_free(Ring *r, void *ptr) {
+    Ring_Record_Header *header;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    if(ptr != ring_peek(r)) {
+        assert(0 && "Out of order ring allocator free");
+        return;
+    }
+
+    header = (Ring_Record_Header *)((unsigned char *)ptr - RING_ALIGNMENT);
+    r->tail += header->size;
+
+    // An empty ring starts over from the beginning, which keeps small records away from the end
+    if(r->tail == r->head) {
+        r->head = 0;
+        r->tail = 0;
+    }
+}
+
+void ring_free_all(Ring *r) {
+    r->head = 0;
+    r->tail = 0;
+}
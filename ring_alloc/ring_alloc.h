@@ -0,0 +1,81 @@
+#ifndef RING_ALLOC_H
+#define RING_ALLOC_H
+
+#ifndef STD_ASSERT
+#define STD_ASSERT
+#include <assert.h>
+#endif
+
+#ifndef STD_BOOL
+#define STD_BOOl
+#include <stdbool.h>
+#endif
+
+#ifndef STD_INT
+#define STD_INT
+#include <stdint.h>
+#endif
+
+#ifndef STD_LIB
+#define STD_LIB
+#include <stdlib.h>
+#endif
+
+#ifndef STD_STRING
+#define STD_STRING
+#include <string.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DEFAULT_ALIGNMENT
+#define DEFAULT_ALIGNMENT (2*sizeof(void *))
+#endif
+
+// Every record starts with a header slot of this size, so payloads are always aligned to it.
+// The header sits at the start of the slot, so filler and regular records can be told apart.
+#ifndef RING_ALIGNMENT
+#define RING_ALIGNMENT DEFAULT_ALIGNMENT
+#endif
+
+// Marks the filler record that pads the end of an unmirrored buffer when a record has to wrap
+#define RING_SKIP ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+typedef struct Ring Ring;
+typedef struct Ring_Record_Header Ring_Record_Header;
+
+struct Ring {
+    unsigned char *buf;
+    size_t buf_len;
+
+    // Both only ever grow, their difference is the amount of used memory
+    size_t head;
+    size_t tail;
+
+    // The buffer is mapped twice back to back, so records can cross the end
+    bool mirrored;
+};
+
+struct Ring_Record_Header {
+    size_t size;
+};
+
+void ring_init(Ring *r, void *backing_buffer, size_t backing_buffer_length);
+bool ring_init_mirrored(Ring *r, size_t size);
+void ring_destroy(Ring *r);
+
+void *ring_alloc(Ring *r, size_t size);
+void ring_free(Ring *r, void *ptr);
+void ring_free_all(Ring *r);
+
+void *ring_peek(Ring *r);
+size_t ring_record_size(void *ptr);
+size_t ring_available(Ring *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
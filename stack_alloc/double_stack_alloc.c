@@ -1,88 +1,80 @@
 #include "double_stack_alloc.h"
 
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x - 1)) == 0;
-}
-
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size) {
-    uintptr_t p, a, modulo, padding, needed_space;
-
-    assert(is_power_of_two(alignment));
-
-    p = ptr;
-    a = alignment;
-    modulo = p & (a - 1);
-
-    padding = 0;
+// Both sides keep the header right below the returned pointer. On the front side padding is the distance from the old
+// start_offset up to the pointer, on the end side the distance from the pointer up to the old end_offset.
+void *double_stack_alloc_align(Double_Stack *s, size_t size, enum StackSide side, size_t alignment) {
+    uintptr_t start, next_addr;
+    size_t padding, prev_offset;
+    Double_Stack_Alloc_Header *header;
 
-    if(modulo != 0) {
-        padding = a - modulo;
-    }
-    needed_space = (uintptr_t) header_size;
+    start = (uintptr_t)s->buf;
 
-    if(padding < needed_space) {
-        needed_space -= padding;
-        if((needed_space & (a-1)) != 0) {
-            padding += a * (1 + (needed_space/a));
-        } else {
-            padding += a * (needed_space/a);
-        }
+    if(alignment < _Alignof(Double_Stack_Alloc_Header)) {
+        alignment = _Alignof(Double_Stack_Alloc_Header);
     }
 
-    return (size_t)padding;
-}
-
-void *stack_alloc_align(Stack *s, size_t size, enum StackSide side, size_t alignment) {
-    uintptr_t curr_addr, next_addr;
-    size_t padding, prev_offset;
-    Stack_Alloc_Header *header;
-
-    if(alignment > 128) {
-        alignment = 128;
-    }
+    if(side == STACK_FRONT) {
+        uintptr_t curr_addr = start + (uintptr_t)s->start_offset;
 
-    curr_addr = (uintptr_t)s->buf + (uintptr_t)(side == STACK_FRONT? s->start_offset : s->end_offset);
-    padding = calc_padding_with_header(curr_addr, alignment, sizeof(Stack_Alloc_Header));
+        padding = calc_padding_with_header(curr_addr, alignment, sizeof(Double_Stack_Alloc_Header));
 
-    if((side == STACK_FRONT && s->start_offset + padding + size >= s->end_offset)
-        || (side == STACK_END && s->end_offset - padding - size <= s->start_offset)) {
-        return NULL;
-    }
+        // Written so a large padding or size can't wrap around
+        if(padding > s->end_offset - s->start_offset || size > s->end_offset - s->start_offset - padding) {
+            return NULL;
+        }
 
-    if(side == STACK_FRONT) {
         next_addr = curr_addr + (uintptr_t)padding;
-        header = (Stack_Alloc_Header *)(next_addr - sizeof(Stack_Alloc_Header));
+
+        // The header keeps the offset a free has to restore as the new previous one
+        prev_offset = s->start_prev_offset;
 
         s->start_prev_offset = s->start_offset;
         s->start_offset += padding + size;
-
-        prev_offset = s->start_offset;
     } else {
-        next_addr = curr_addr - (uintptr_t)padding;
-        header = (Stack_Alloc_Header *)(next_addr + sizeof(Stack_Alloc_Header));
+        uintptr_t curr_addr = start + (uintptr_t)s->end_offset;
 
-        s->end_prev_offset = s->end_offset; 
-        s->end_offset -= padding - size; 
+        if(size > s->end_offset - s->start_offset) {
+            return NULL;
+        }
 
-        prev_offset = s->end_offset;
+        // The end side grows down, so the block is aligned backwards from the end and the header goes below it
+        next_addr = align_backward(curr_addr - (uintptr_t)size, alignment);
+        if(next_addr < start + (uintptr_t)s->start_offset + sizeof(Double_Stack_Alloc_Header)) {
+            return NULL;
+        }
+        padding = (size_t)(curr_addr - next_addr);
+
+        prev_offset = s->end_prev_offset;
+
+        s->end_prev_offset = s->end_offset;
+        s->end_offset = (size_t)(next_addr - sizeof(Double_Stack_Alloc_Header) - start);
     }
 
-    header->padding = (uint8_t)padding;
+    header = (Double_Stack_Alloc_Header *)(next_addr - sizeof(Double_Stack_Alloc_Header));
+    header->padding = padding;
     header->prev_offset = prev_offset;
 
     return memset((void*)next_addr, 0, size);
 }
 
-void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size, enum StackSide side, size_t alignment) {
+// The offset the side had before ptr was allocated
+size_t double_stack_prev_offset(Double_Stack *s, void *ptr, enum StackSide side) {
+    Double_Stack_Alloc_Header *header = (Double_Stack_Alloc_Header *)((uintptr_t)ptr - sizeof(Double_Stack_Alloc_Header));
+    size_t offset = (size_t)((uintptr_t)ptr - (uintptr_t)s->buf);
+
+    return side == STACK_FRONT? offset - header->padding : offset + header->padding;
+}
+
+void *double_stack_resize_align(Double_Stack *s, void *ptr, size_t old_size, size_t new_size, enum StackSide side, size_t alignment) {
     if (!ptr) {
-        return stack_alloc_align(s, new_size, side, alignment);
+        return double_stack_alloc_align(s, new_size, side, alignment);
     } else if (new_size == 0) {
-        stack_free(s, ptr, side);
+        double_stack_free(s, ptr, side);
         return NULL;
     } else {
-        uintptr_t start, end, curr_addr, prev_offset;
+        uintptr_t start, end, curr_addr;
         size_t min_size = old_size < new_size? old_size : new_size;
-        Stack_Alloc_Header *header;
+        size_t prev_offset;
         void *new_ptr;
 
         start = (uintptr_t)s->buf;
@@ -94,50 +86,81 @@ void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size,
             return NULL;
         }
 
-        if (old_size == min_size) {
+        if (new_size <= old_size) {
             return ptr;
         }
 
-        header = (Stack_Alloc_Header *)(curr_addr - sizeof(Stack_Alloc_Header));
-        prev_offset = (size_t)(curr_addr + ((side == STACK_FRONT? -1 : 1) * header->padding) - start);
+        prev_offset = double_stack_prev_offset(s, ptr, side);
 
-        if ((side == STACK_FRONT && prev_offset != s->start_prev_offset) ||
-            (side == STACK_END && prev_offset != s->end_prev_offset)) {
-            new_ptr = stack_alloc_align(s, new_size, side, alignment);
-        } else {
-            new_ptr = (void *)(curr_addr + (uintptr_t)new_size);
-            if (side == STACK_FRONT) {
-                s->start_offset = (size_t)(curr_addr + new_size - start);
-            } else {
-                s->end_offset = (size_t)(curr_addr - new_size - start);
+        if(side == STACK_FRONT && prev_offset == s->start_prev_offset) {
+            // The last front block grows in place, as long as it doesn't run into the end side
+            size_t offset = (size_t)(curr_addr - start);
+
+            if(new_size <= s->end_offset - offset) {
+                s->start_offset = offset + new_size;
+                memset((void *)(curr_addr + old_size), 0, new_size - old_size);
+                return ptr;
+            }
+        } else if(side == STACK_END && prev_offset == s->end_prev_offset) {
+            // The last end block keeps its top and grows downwards, so it is popped and placed again
+            Double_Stack_Alloc_Header *header = (Double_Stack_Alloc_Header *)(curr_addr - sizeof(Double_Stack_Alloc_Header));
+            size_t header_prev_offset = header->prev_offset;
+            uintptr_t top = start + (uintptr_t)prev_offset;
+
+            if(alignment < _Alignof(Double_Stack_Alloc_Header)) {
+                alignment = _Alignof(Double_Stack_Alloc_Header);
+            }
+
+            if(new_size <= prev_offset - s->start_offset) {
+                uintptr_t next_addr = align_backward(top - (uintptr_t)new_size, alignment);
+
+                if(next_addr >= start + (uintptr_t)s->start_offset + sizeof(Double_Stack_Alloc_Header)) {
+                    Double_Stack_Alloc_Header *new_header;
+
+                    // The old header may lie inside the moved data, so it was read before the move
+                    memmove((void *)next_addr, ptr, old_size);
+                    memset((void *)(next_addr + old_size), 0, new_size - old_size);
+
+                    new_header = (Double_Stack_Alloc_Header *)(next_addr - sizeof(Double_Stack_Alloc_Header));
+                    new_header->padding = (size_t)(top - next_addr);
+                    new_header->prev_offset = header_prev_offset;
+
+                    s->end_offset = (size_t)(next_addr - sizeof(Double_Stack_Alloc_Header) - start);
+                    return (void *)next_addr;
+                }
             }
         }
 
+        new_ptr = double_stack_alloc_align(s, new_size, side, alignment);
+        if(new_ptr == NULL) {
+            return NULL;
+        }
+
         memmove(new_ptr, ptr, min_size);
         return new_ptr;
     }
 }
 
-void *stack_alloc_front(Stack *s, size_t size) {
-    return stack_alloc_align(s, size, STACK_FRONT, DEFAULT_ALIGNMENT);
+void *double_stack_alloc_front(Double_Stack *s, size_t size) {
+    return double_stack_alloc_align(s, size, STACK_FRONT, DEFAULT_ALIGNMENT);
 }
 
-void *stack_alloc_end(Stack *s, size_t size) {
-    return stack_alloc_align(s, size, STACK_END, DEFAULT_ALIGNMENT);
+void *double_stack_alloc_end(Double_Stack *s, size_t size) {
+    return double_stack_alloc_align(s, size, STACK_END, DEFAULT_ALIGNMENT);
 }
 
-void *stack_resize_front(Stack *s, void *ptr, size_t old_size, size_t new_size) {
-    return stack_resize_align(s, ptr, old_size, new_size, STACK_FRONT, DEFAULT_ALIGNMENT);
+void *double_stack_resize_front(Double_Stack *s, void *ptr, size_t old_size, size_t new_size) {
+    return double_stack_resize_align(s, ptr, old_size, new_size, STACK_FRONT, DEFAULT_ALIGNMENT);
 }
 
-void *stack_resize_end(Stack *s, void *ptr, size_t old_size, size_t new_size) {
-    return stack_resize_align(s, ptr, old_size, new_size, STACK_END, DEFAULT_ALIGNMENT);
+void *double_stack_resize_end(Double_Stack *s, void *ptr, size_t old_size, size_t new_size) {
+    return double_stack_resize_align(s, ptr, old_size, new_size, STACK_END, DEFAULT_ALIGNMENT);
 }
 
-void stack_free(Stack *s, void *ptr, enum StackSide side) {
+void double_stack_free(Double_Stack *s, void *ptr, enum StackSide side) {
     if(ptr != NULL) {
         uintptr_t start, end, curr_addr;
-        Stack_Alloc_Header *header;
+        Double_Stack_Alloc_Header *header;
         size_t prev_offset;
 
         start = (uintptr_t)s->buf;
@@ -149,14 +172,14 @@ void stack_free(Stack *s, void *ptr, enum StackSide side) {
             return;
         }
 
-        if((side == STACK_FRONT && curr_addr >= start+(uintptr_t)s->start_offset) ||
-            (side == STACK_END && curr_addr <= start+(uintptr_t)s->end_offset)) {
-            // Double free
+        if((side == STACK_FRONT && curr_addr > start+(uintptr_t)s->start_offset) ||
+            (side == STACK_END && curr_addr < start+(uintptr_t)s->end_offset+sizeof(Double_Stack_Alloc_Header))) {
+            // Double free, a zero sized block on top sits exactly at start_offset so that one is still live
             return;
         }
 
-        header = (Stack_Alloc_Header *)(curr_addr + sizeof(Stack_Alloc_Header));
-        prev_offset = (size_t)(curr_addr - (uintptr_t)header->padding - start);
+        header = (Double_Stack_Alloc_Header *)(curr_addr - sizeof(Double_Stack_Alloc_Header));
+        prev_offset = double_stack_prev_offset(s, ptr, side);
 
         if((side == STACK_FRONT && prev_offset != s->start_prev_offset) ||
             (side == STACK_END && prev_offset != s->end_prev_offset)) {
@@ -174,28 +197,26 @@ void stack_free(Stack *s, void *ptr, enum StackSide side) {
     }
 }
 
-void stack_free_front(Stack *s, void *ptr) {
-    stack_free(s, ptr, STACK_FRONT);
+void double_stack_free_front(Double_Stack *s, void *ptr) {
+    double_stack_free(s, ptr, STACK_FRONT);
 }
 
-void stack_free_end(Stack *s, void *ptr) {
-    stack_free(s, ptr, STACK_END);
+void double_stack_free_end(Double_Stack *s, void *ptr) {
+    double_stack_free(s, ptr, STACK_END);
 }
 
-void stack_free_all(Stack *s) {
+void double_stack_free_all(Double_Stack *s) {
     s->start_offset = 0;
     s->start_prev_offset = 0;
-    s->end_offset = s->buf_len - 1;
-    s->end_prev_offset = s->buf_len - 1;
+    s->end_offset = s->buf_len;
+    s->end_prev_offset = s->buf_len;
 }
 
-void stack_init(Stack *s, void *backing_buffer, size_t backing_buffer_length) {
+void double_stack_init(Double_Stack *s, void *backing_buffer, size_t backing_buffer_length) {
     s->buf = (unsigned char *)backing_buffer;
     s->buf_len = backing_buffer_length;
     s->start_offset = 0;
     s->start_prev_offset = 0;
-    s->end_offset = backing_buffer_length - 1;
-    s->end_prev_offset = backing_buffer_length - 1;
+    s->end_offset = backing_buffer_length;
+    s->end_prev_offset = backing_buffer_length;
 }
-
-int main(){}
@@ -1,3 +1,6 @@
+#ifndef DOUBLE_STACK_ALLOC_H
+#define DOUBLE_STACK_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,40 +26,52 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
 enum StackSide { STACK_FRONT, STACK_END };
 
-typedef struct Stack Stack;
-typedef struct Stack_Alloc_Header Stack_Alloc_Header;
+typedef struct Double_Stack Double_Stack;
+typedef struct Double_Stack_Alloc_Header Double_Stack_Alloc_Header;
 
-struct Stack {
+struct Double_Stack {
     unsigned char *buf;
     size_t buf_len;
     size_t start_offset;
     size_t start_prev_offset;
+    // The end side grows down from buf_len, end_offset is the lowest byte it uses
     size_t end_offset;
     size_t end_prev_offset;
 };
 
-struct Stack_Alloc_Header {
+struct Double_Stack_Alloc_Header {
     size_t prev_offset;
     size_t padding;
 };
 
-bool is_power_of_two(uintptr_t x);
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size);
-void *stack_alloc_align(Stack *s, size_t size, enum StackSide side, size_t alignment);
-void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size, enum StackSide side, size_t alignment);
-
-void *stack_alloc_end(Stack *s, size_t size);
-void *stack_alloc_front(Stack *s, size_t size);
-void *stack_resize_end(Stack *s, void *ptr, size_t old_size, size_t new_size);
-void *stack_resize_front(Stack *s, void *ptr, size_t old_size, size_t new_size);
-void stack_free(Stack *s, void *ptr, enum StackSide side);
-void stack_free_all(Stack *s);
-void stack_free_end(Stack *s, void *ptr);
-void stack_free_front(Stack *s, void *ptr);
-void stack_init(Stack *s, void *backing_buffer, size_t backing_buffer_length);
+void *double_stack_alloc_align(Double_Stack *s, size_t size, enum StackSide side, size_t alignment);
+size_t double_stack_prev_offset(Double_Stack *s, void *ptr, enum StackSide side);
+void *double_stack_resize_align(Double_Stack *s, void *ptr, size_t old_size, size_t new_size, enum StackSide side, size_t alignment);
+
+void *double_stack_alloc_end(Double_Stack *s, size_t size);
+void *double_stack_alloc_front(Double_Stack *s, size_t size);
+void *double_stack_resize_end(Double_Stack *s, void *ptr, size_t old_size, size_t new_size);
+void *double_stack_resize_front(Double_Stack *s, void *ptr, size_t old_size, size_t new_size);
+void double_stack_free(Double_Stack *s, void *ptr, enum StackSide side);
+void double_stack_free_all(Double_Stack *s);
+void double_stack_free_end(Double_Stack *s, void *ptr);
+void double_stack_free_front(Double_Stack *s, void *ptr);
+void double_stack_init(Double_Stack *s, void *backing_buffer, size_t backing_buffer_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+// Standalone check of the double-ended stack, build and run with:
+//
+//     cc -std=gnu11 -g stack_alloc/double_stack_test.c stack_alloc/double_stack_alloc.c -o double_stack_test
+//     ./double_stack_test
+//
+// Alignments past the fuzzing go up to 1 GiB on a reserved 3 GiB mapping, only the pages around the blocks are ever
+// touched.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "double_stack_alloc.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+#define TEST_BUFFER_SIZE (1 << 20)
+#define TEST_MAX_BLOCKS 256
+#define TEST_STEPS 200000
+// Checking every byte of every block is slow, so the contents are only checked every so many steps
+#define TEST_CONTENT_EVERY 256
+#define TEST_MAPPING_SIZE ((size_t)3 << 30)
+#define TEST_MAX_ALIGNMENT_SHIFT 30
+#define TEST_BLOCK_SIZE 64
+
+typedef struct Test_Block Test_Block;
+struct Test_Block {
+    unsigned char *ptr;
+    size_t size;
+    unsigned char fill;
+};
+
+static _Alignas(4096) unsigned char test_buffer[TEST_BUFFER_SIZE];
+
+static Test_Block blocks[2][TEST_MAX_BLOCKS];
+static size_t block_count[2];
+
+static uint64_t test_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t test_random(void) {
+    test_state ^= test_state << 13;
+    test_state ^= test_state >> 7;
+    test_state ^= test_state << 17;
+    return test_state;
+}
+
+static void test_check(Double_Stack *s, bool contents) {
+    unsigned char *front_top = s->buf;
+    unsigned char *end_bottom = s->buf + s->buf_len;
+
+    for(size_t side = 0; side < 2; side++) {
+        for(size_t i = 0; i < block_count[side]; i++) {
+            Test_Block *b = &blocks[side][i];
+
+            for(size_t j = 0; contents && j < b->size; j++) {
+                assert(b->ptr[j] == b->fill && "Block was overwritten");
+            }
+            assert(s->buf <= b->ptr && b->ptr + b->size <= s->buf + s->buf_len);
+
+            // Front blocks go up and end blocks go down, each new one strictly past the one before
+            if(side == STACK_FRONT) {
+                assert(b->ptr >= front_top);
+                front_top = b->ptr + b->size;
+            } else {
+                assert(b->ptr + b->size <= end_bottom);
+                end_bottom = b->ptr - sizeof(Double_Stack_Alloc_Header);
+            }
+        }
+    }
+
+    assert(front_top <= end_bottom && "Front and end blocks overlap");
+    assert(s->start_offset <= s->end_offset);
+}
+
+static void test_large_block(unsigned char *ptr, size_t alignment, unsigned char fill) {
+    assert(ptr != NULL);
+    assert(((uintptr_t)ptr & (alignment - 1)) == 0 && "Misaligned block");
+    for(size_t i = 0; i < TEST_BLOCK_SIZE; i++) {
+        assert(ptr[i] == 0 && "Block is not zeroed");
+    }
+    memset(ptr, fill, TEST_BLOCK_SIZE);
+}
+
+// On both sides a 1 byte block first puts the offset off every alignment, then a block with a large alignment is
+// nested inside one with a small alignment and the other way round. LIFO frees have to bring back every offset.
+static void test_large_alignments(void) {
+    void *map = mmap(NULL, TEST_MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Double_Stack s;
+
+    assert(map != MAP_FAILED && "Could not reserve the test mapping");
+    double_stack_init(&s, map, TEST_MAPPING_SIZE);
+
+    for(size_t shift = 0; shift <= TEST_MAX_ALIGNMENT_SHIFT; shift++) {
+        for(size_t side = 0; side < 2; side++) {
+            size_t alignment = (size_t)1 << shift;
+            size_t inner_alignment = (size_t)1 << (TEST_MAX_ALIGNMENT_SHIFT - shift);
+            size_t *offset = side == STACK_FRONT? &s.start_offset : &s.end_offset;
+            size_t start_offset, outer_offset, inner_offset;
+            unsigned char *odd, *outer, *inner;
+
+            start_offset = *offset;
+            odd = (unsigned char *)double_stack_alloc_align(&s, 1, (enum StackSide)side, 1);
+            assert(odd != NULL);
+            *odd = 0x11;
+
+            outer_offset = *offset;
+            outer = (unsigned char *)double_stack_alloc_align(&s, TEST_BLOCK_SIZE, (enum StackSide)side, alignment);
+            test_large_block(outer, alignment, 0x22);
+
+            inner_offset = *offset;
+            inner = (unsigned char *)double_stack_alloc_align(&s, TEST_BLOCK_SIZE, (enum StackSide)side,
+                                                               inner_alignment);
+            test_large_block(inner, inner_alignment, 0x33);
+
+            double_stack_free(&s, inner, (enum StackSide)side);
+            assert(*offset == inner_offset);
+            assert(outer[0] == 0x22 && outer[TEST_BLOCK_SIZE - 1] == 0x22);
+            double_stack_free(&s, outer, (enum StackSide)side);
+            assert(*offset == outer_offset);
+            assert(*odd == 0x11);
+            double_stack_free(&s, odd, (enum StackSide)side);
+            assert(*offset == start_offset);
+        }
+    }
+    assert(s.start_offset == 0 && s.end_offset == s.buf_len);
+
+    munmap(map, TEST_MAPPING_SIZE);
+}
+
+int main(void) {
+    Double_Stack s;
+    size_t allocs = 0, resizes = 0, frees = 0;
+
+    double_stack_init(&s, test_buffer, TEST_BUFFER_SIZE);
+
+    for(size_t step = 0; step < TEST_STEPS; step++) {
+        // Alternate sides, with a random operation on each
+        enum StackSide side = (enum StackSide)(step & 1);
+        size_t *count = &block_count[side];
+        uint64_t r = test_random();
+        size_t op = (size_t)(r % 10);
+
+        if(op < 5 && *count < TEST_MAX_BLOCKS) {
+            size_t size = (size_t)(test_random() % 2048);
+            size_t alignment = (size_t)1 << (test_random() % 13);
+            unsigned char *ptr = (unsigned char *)double_stack_alloc_align(&s, size, side, alignment);
+
+            if(ptr != NULL) {
+                Test_Block *b = &blocks[side][(*count)++];
+
+                assert(((uintptr_t)ptr & (alignment - 1)) == 0 && "Misaligned block");
+                b->ptr = ptr;
+                b->size = size;
+                b->fill = (unsigned char)(test_random() | 1);
+                memset(ptr, b->fill, size);
+                allocs++;
+            }
+        } else if(op < 7 && *count > 0) {
+            Test_Block *b = &blocks[side][*count - 1];
+            size_t new_size = (size_t)(test_random() % 4096) + 1;
+            size_t alignment = (size_t)1 << (test_random() % 8);
+            size_t keep = b->size < new_size? b->size : new_size;
+            size_t prev_offset = double_stack_prev_offset(&s, b->ptr, side);
+            unsigned char *ptr = (unsigned char *)double_stack_resize_align(&s, b->ptr, b->size, new_size, side, alignment);
+
+            if(ptr != NULL) {
+                for(size_t j = 0; j < keep; j++) {
+                    assert(ptr[j] == b->fill && "Resize lost the data");
+                }
+                if(new_size <= b->size) {
+                    // Shrinking keeps the block as it is
+                    assert(ptr == b->ptr);
+                } else if(double_stack_prev_offset(&s, ptr, side) == prev_offset) {
+                    // Resized in place, the front side keeps the pointer and the end side moves it down
+                    assert(side == STACK_END || ptr == b->ptr);
+                    assert(side == STACK_FRONT || ((uintptr_t)ptr & (alignment - 1)) == 0);
+                    b->ptr = ptr;
+                    b->size = new_size;
+                    memset(ptr, b->fill, new_size);
+                } else {
+                    // Moved to a new block on top, the old one stays allocated below it
+                    Test_Block *moved = &blocks[side][(*count)++];
+
+                    assert(((uintptr_t)ptr & (alignment - 1)) == 0 && "Misaligned block");
+                    assert(*count <= TEST_MAX_BLOCKS);
+                    moved->ptr = ptr;
+                    moved->size = new_size;
+                    moved->fill = b->fill;
+                    memset(ptr, b->fill, new_size);
+                }
+                resizes++;
+            }
+        } else if(*count > 0) {
+            Test_Block *b = &blocks[side][--(*count)];
+
+            double_stack_free(&s, b->ptr, side);
+            frees++;
+        }
+
+        test_check(&s, step % TEST_CONTENT_EVERY == 0);
+
+        if(block_count[0] == TEST_MAX_BLOCKS - 1 || block_count[1] == TEST_MAX_BLOCKS - 1) {
+            double_stack_free_all(&s);
+            block_count[0] = 0;
+            block_count[1] = 0;
+        }
+    }
+
+    // Freeing everything in LIFO order brings both sides back to the ends of the buffer
+    for(size_t side = 0; side < 2; side++) {
+        while(block_count[side] > 0) {
+            double_stack_free(&s, blocks[side][--block_count[side]].ptr, (enum StackSide)side);
+        }
+    }
+    assert(s.start_offset == 0 && s.end_offset == s.buf_len);
+
+    test_large_alignments();
+
+    printf("double stack: %zu allocs, %zu resizes, %zu frees and alignments up to 1 << %d passed\n",
+           allocs, resizes, frees, TEST_MAX_ALIGNMENT_SHIFT);
+    return 0;
+}
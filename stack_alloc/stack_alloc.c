@@ -1,38 +1,13 @@
 #include "stack_alloc.h"
 
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size) {
-    uintptr_t p, a, modulo, padding, needed_space;
-
-    assert(is_power_of_two(alignment));
-
-    p = ptr;
-    a = alignment;
-    modulo = p & (a - 1);
-
-    padding = 0;
-    needed_space = 0;
+size_t stack_header_padding(Stack_Allocation_Header *header) {
+    size_t padding = header->padding;
 
-    if(modulo != 0) {
-        padding = a - modulo;
-    }
-
-    needed_space = (uintptr_t)header_size;
-
-    if(padding < needed_space) {
-        needed_space -= padding;
-
-        if((needed_space & (a-1)) != 0) {
-            padding += a * (1+(needed_space/a));
-        } else {
-            padding += a * (needed_space/a);
-        }
+    if(padding == STACK_PADDING_ESCAPE) {
+        memcpy(&padding, (unsigned char *)header - sizeof(size_t), sizeof(size_t));
     }
 
-    return (size_t)padding;
+    return padding;
 }
 
 void *stack_alloc_align(Stack *s, size_t size, size_t alignment) {
@@ -40,14 +15,14 @@ void *stack_alloc_align(Stack *s, size_t size, size_t alignment) {
     size_t padding;
     Stack_Allocation_Header *header;
 
-    if(alignment > 128) {
-        // The padding is 8 bits, the largest alignment can be used is 128 bytes.
-        alignment = 128;
-    }
-
     curr_addr = (uintptr_t)s->buf + (uintptr_t)s->offset;
     padding = calc_padding_with_header(curr_addr, (uintptr_t)alignment, sizeof(Stack_Allocation_Header));
-    if(s->offset + padding + size > s->buf_len) {
+    if(padding >= STACK_PADDING_ESCAPE) {
+        // Only large alignments get here, they pay for the extra size_t, small ones keep the 1 byte header
+        padding = calc_padding_with_header(curr_addr, (uintptr_t)alignment, sizeof(Stack_Allocation_Header) + sizeof(size_t));
+    }
+
+    if(padding > s->buf_len - s->offset || size > s->buf_len - s->offset - padding) {
         // Stack allocator is out of memory
         return NULL;
     }
@@ -55,7 +30,12 @@ void *stack_alloc_align(Stack *s, size_t size, size_t alignment) {
 
     next_addr = curr_addr + (uintptr_t)padding;
     header = (Stack_Allocation_Header *)(next_addr - sizeof(Stack_Allocation_Header));
-    header->padding = (uint8_t)padding;
+    if(padding >= STACK_PADDING_ESCAPE) {
+        header->padding = STACK_PADDING_ESCAPE;
+        memcpy((unsigned char *)header - sizeof(size_t), &padding, sizeof(size_t));
+    } else {
+        header->padding = (uint8_t)padding;
+    }
 
     s->offset += size;
 
@@ -90,15 +70,24 @@ void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size,
             return NULL;
         }
 
-        if (old_size == min_size) {
+        if (new_size <= old_size) {
             return ptr;
         }
 
-        if ((size_t)(curr_addr + old_size - start) != s->offset) {
-            new_ptr = stack_alloc_align(s, new_size, alignment);
-        } else {
-            new_ptr = (void *)(curr_addr + (uintptr_t)new_size);
-            s->offset = (size_t)(curr_addr + new_size - start);
+        if ((size_t)(curr_addr + old_size - start) == s->offset) {
+            // The last block grows in place as long as it stays within the buffer
+            size_t offset = (size_t)(curr_addr - start);
+
+            if(new_size <= s->buf_len - offset) {
+                s->offset = offset + new_size;
+                memset((void *)(curr_addr + old_size), 0, new_size - old_size);
+                return ptr;
+            }
+        }
+
+        new_ptr = stack_alloc_align(s, new_size, alignment);
+        if(new_ptr == NULL) {
+            return NULL;
         }
 
         memmove(new_ptr, ptr, min_size);
@@ -130,8 +119,8 @@ void stack_free(Stack *s, void *ptr) {
             return;
         }
 
-        header = (Stack_Allocation_Header *)(curr_addr + sizeof(Stack_Allocation_Header));
-        prev_offset = (size_t)(curr_addr - (uintptr_t)header->padding - start);
+        header = (Stack_Allocation_Header *)(curr_addr - sizeof(Stack_Allocation_Header));
+        prev_offset = (size_t)(curr_addr - (uintptr_t)stack_header_padding(header) - start);
 
         s->offset = prev_offset;
     }
@@ -146,4 +135,3 @@ void stack_init(Stack *s, void *backing_buffer, size_t backing_buffer_length) {
     s->buf_len = backing_buffer_length;
     s->offset = 0;
 }
-int main(){}
@@ -1,3 +1,6 @@
+#ifndef STACK_ALLOC_H
+#define STACK_ALLOC_H
+
 #ifndef STD_ASSERT
 #define STD_ASSERT
 #include <assert.h>
@@ -23,16 +26,22 @@
 #include <string.h>
 #endif
 
+#include "../core/align.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+// Paddings that don't fit into the header are stored in full in a size_t right before it, the header then holds this
+#define STACK_PADDING_ESCAPE UINT8_MAX
+
 typedef struct Stack Stack;
 typedef struct Stack_Allocation_Header Stack_Allocation_Header;
 
-typedef struct Strict_Stack Strict_Stack;
-typedef struct Strict_Stack_Alloc_Header Strict_Stack_Alloc_Header;
-
 struct Stack {
     unsigned char *buf;
     size_t buf_len;
@@ -43,8 +52,7 @@ struct Stack_Allocation_Header {
     uint8_t padding;
 };
 
-bool is_power_of_two(uintptr_t x);
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size);
+size_t stack_header_padding(Stack_Allocation_Header *header);
 void *stack_alloc_align(Stack *s, size_t size, size_t alignment);
 void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size, size_t alignment);
 
@@ -53,3 +61,9 @@ void *stack_resize(Stack *s, void *ptr, size_t old_size, size_t new_size);
 void stack_free(Stack *s, void *ptr);
 void stack_free_all(Stack *s);
 void stack_init(Stack *s, void *backing_buffer, size_t backing_buffer_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+// Standalone check of the stack and the strict stack, build and run with:
+//
+//     cc -std=gnu11 -g stack_alloc/stack_test.c stack_alloc/stack_alloc.c stack_alloc/strict_stack_alloc.c
+//         -o stack_test
+//     ./stack_test
+//
+// Alignments go up to 1 GiB on a reserved 3 GiB mapping, only the pages around the blocks are ever touched.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "stack_alloc.h"
+#include "strict_stack_alloc.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+#define TEST_MAPPING_SIZE ((size_t)3 << 30)
+#define TEST_MAX_ALIGNMENT_SHIFT 30
+#define TEST_BLOCK_SIZE 64
+#define TEST_BUFFER_SIZE 4096
+
+static _Alignas(4096) unsigned char test_buffer[TEST_BUFFER_SIZE];
+
+static unsigned char *test_map(void) {
+    void *map = mmap(NULL, TEST_MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    assert(map != MAP_FAILED && "Could not reserve the test mapping");
+    return (unsigned char *)map;
+}
+
+static void test_block(unsigned char *ptr, size_t size, size_t alignment, unsigned char fill) {
+    assert(ptr != NULL);
+    assert(((uintptr_t)ptr & (alignment - 1)) == 0 && "Misaligned block");
+    for(size_t i = 0; i < size; i++) {
+        assert(ptr[i] == 0 && "Block is not zeroed");
+    }
+    memset(ptr, fill, size);
+}
+
+// A 1 byte block first puts the offset off every alignment, then a block with a large alignment is nested inside one
+// with a small alignment and the other way round. Freeing them in LIFO order has to bring back every offset.
+static void test_stack_alignments(void) {
+    unsigned char *map = test_map();
+    Stack s;
+
+    stack_init(&s, map, TEST_MAPPING_SIZE);
+
+    for(size_t shift = 0; shift <= TEST_MAX_ALIGNMENT_SHIFT; shift++) {
+        size_t alignment = (size_t)1 << shift;
+        size_t inner_alignment = (size_t)1 << (TEST_MAX_ALIGNMENT_SHIFT - shift);
+        size_t start_offset, outer_offset, inner_offset;
+        unsigned char *odd, *outer, *inner;
+
+        start_offset = s.offset;
+        odd = (unsigned char *)stack_alloc_align(&s, 1, 1);
+        test_block(odd, 1, 1, 0x11);
+
+        outer_offset = s.offset;
+        outer = (unsigned char *)stack_alloc_align(&s, TEST_BLOCK_SIZE, alignment);
+        test_block(outer, TEST_BLOCK_SIZE, alignment, 0x22);
+        assert(stack_header_padding((Stack_Allocation_Header *)outer - 1) == (size_t)(outer - map) - outer_offset);
+
+        inner_offset = s.offset;
+        inner = (unsigned char *)stack_alloc_align(&s, TEST_BLOCK_SIZE, inner_alignment);
+        test_block(inner, TEST_BLOCK_SIZE, inner_alignment, 0x33);
+
+        stack_free(&s, inner);
+        assert(s.offset == inner_offset);
+        assert(outer[TEST_BLOCK_SIZE - 1] == 0x22 && "Escaped padding overwrote the block below");
+        stack_free(&s, outer);
+        assert(s.offset == outer_offset);
+        stack_free(&s, odd);
+        assert(s.offset == start_offset);
+    }
+
+    munmap(map, TEST_MAPPING_SIZE);
+}
+
+static void test_strict_stack_alignments(void) {
+    unsigned char *map = test_map();
+    Strict_Stack s;
+
+    strict_stack_init(&s, map, TEST_MAPPING_SIZE);
+
+    for(size_t shift = 0; shift <= TEST_MAX_ALIGNMENT_SHIFT; shift++) {
+        size_t alignment = (size_t)1 << shift;
+        size_t inner_alignment = (size_t)1 << (TEST_MAX_ALIGNMENT_SHIFT - shift);
+        size_t start_offset, start_prev, outer_offset, inner_offset;
+        unsigned char *odd, *outer, *inner;
+
+        start_offset = s.curr_offset;
+        start_prev = s.prev_offset;
+        odd = (unsigned char *)strict_stack_alloc_align(&s, 1, 1);
+        test_block(odd, 1, 1, 0x11);
+
+        outer_offset = s.curr_offset;
+        outer = (unsigned char *)strict_stack_alloc_align(&s, TEST_BLOCK_SIZE, alignment);
+        test_block(outer, TEST_BLOCK_SIZE, alignment, 0x22);
+        assert(s.prev_offset == outer_offset);
+
+        inner_offset = s.curr_offset;
+        inner = (unsigned char *)strict_stack_alloc_align(&s, TEST_BLOCK_SIZE, inner_alignment);
+        test_block(inner, TEST_BLOCK_SIZE, inner_alignment, 0x33);
+        assert(s.prev_offset == inner_offset);
+
+        strict_stack_free(&s, inner);
+        assert(s.curr_offset == inner_offset && s.prev_offset == outer_offset);
+        strict_stack_free(&s, outer);
+        assert(s.curr_offset == outer_offset);
+        strict_stack_free(&s, odd);
+        assert(s.curr_offset == start_offset && s.prev_offset == start_prev);
+    }
+
+    munmap(map, TEST_MAPPING_SIZE);
+}
+
+// The last block grows in place, any other block moves, and a growth that fits nowhere fails without a copy
+static void test_stack_resize(void) {
+    Stack s;
+    unsigned char *a, *b, *c;
+    size_t offset;
+
+    stack_init(&s, test_buffer, TEST_BUFFER_SIZE);
+
+    a = (unsigned char *)stack_alloc(&s, 32);
+    memset(a, 0xaa, 32);
+    b = (unsigned char *)stack_alloc(&s, 32);
+    memset(b, 0xbb, 32);
+
+    assert(stack_resize(&s, b, 32, 16) == b);
+
+    assert(stack_resize(&s, b, 32, 256) == b && "The last block grows in place");
+    assert(b[31] == 0xbb && b[32] == 0 && b[255] == 0);
+    assert(s.offset == (size_t)(b - test_buffer) + 256);
+
+    offset = s.offset;
+    assert(stack_resize(&s, b, 256, TEST_BUFFER_SIZE) == NULL && "Growing past the buffer has to fail");
+    assert(s.offset == offset);
+
+    c = (unsigned char *)stack_resize(&s, a, 32, 64);
+    assert(c != NULL && c > b && "Only the last block grows in place");
+    assert(c[0] == 0xaa && c[31] == 0xaa && c[32] == 0);
+
+    assert(stack_resize(&s, a, 32, TEST_BUFFER_SIZE) == NULL);
+}
+
+static void test_strict_stack_resize(void) {
+    Strict_Stack s;
+    unsigned char *a, *b, *c;
+    size_t offset;
+
+    strict_stack_init(&s, test_buffer, TEST_BUFFER_SIZE);
+
+    a = (unsigned char *)strict_stack_alloc(&s, 32);
+    memset(a, 0xaa, 32);
+    b = (unsigned char *)strict_stack_alloc(&s, 32);
+    memset(b, 0xbb, 32);
+
+    assert(strict_stack_resize(&s, b, 32, 16) == b);
+
+    assert(strict_stack_resize(&s, b, 32, 256) == b && "The last block grows in place");
+    assert(b[31] == 0xbb && b[32] == 0 && b[255] == 0);
+    assert(s.curr_offset == (size_t)(b - test_buffer) + 256);
+
+    offset = s.curr_offset;
+    assert(strict_stack_resize(&s, b, 256, TEST_BUFFER_SIZE) == NULL && "Growing past the buffer has to fail");
+    assert(s.curr_offset == offset);
+
+    c = (unsigned char *)strict_stack_resize(&s, a, 32, 64);
+    assert(c != NULL && c > b && "Only the last block grows in place");
+    assert(c[0] == 0xaa && c[31] == 0xaa && c[32] == 0);
+
+    strict_stack_free(&s, c);
+    strict_stack_free(&s, b);
+    strict_stack_free(&s, a);
+    assert(s.curr_offset == 0 && s.prev_offset == 0);
+}
+
+int main(void) {
+    test_stack_alignments();
+    test_strict_stack_alignments();
+    test_stack_resize();
+    test_strict_stack_resize();
+
+    printf("stack: alignments up to 1 << %d and resizes passed\n", TEST_MAX_ALIGNMENT_SHIFT);
+    return 0;
+}
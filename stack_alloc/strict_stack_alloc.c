@@ -1,79 +1,45 @@
 #include "strict_stack_alloc.h"
 
-inline bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-size_t calc_padding_with_header(uintptr_t ptr, uintptr_t alignment, size_t header_size) {
-    uintptr_t p, a, modulo, padding, needed_space;
-
-    assert(is_power_of_two(alignment));
-
-    p = ptr;
-    a = alignment;
-    modulo = p & (a - 1);
-
-    padding = 0;
-    needed_space = 0;
-
-    if(modulo != 0) {
-        padding = a - modulo;
-    }
-
-    needed_space = (uintptr_t)header_size;
-
-    if(padding < needed_space) {
-        needed_space -= padding;
-
-        if((needed_space & (a-1)) != 0) {
-            padding += a * (1+(needed_space/a));
-        } else {
-            padding += a * (needed_space/a);
-        }
-    }
-
-    return (size_t)padding;
-}
-
-void *stack_alloc_align(Stack *s, size_t size, size_t alignment) {
+void *strict_stack_alloc_align(Strict_Stack *s, size_t size, size_t alignment) {
     uintptr_t curr_addr, next_addr;
     size_t padding;
-    Stack_Alloc_Header *header;
+    Strict_Stack_Alloc_Header *header;
 
-    if(alignment > 128) {
-        // The padding is 8 bits, the largest alignment can be used is 128 bytes.
-        alignment = 128;
+    // The header sits right below the block, so the block is aligned for the header as well
+    if(alignment < _Alignof(Strict_Stack_Alloc_Header)) {
+        alignment = _Alignof(Strict_Stack_Alloc_Header);
     }
 
     curr_addr = (uintptr_t)s->buf + (uintptr_t)s->curr_offset;
-    padding = calc_padding_with_header(curr_addr, (uintptr_t)alignment, sizeof(Stack_Alloc_Header));
-    if(s->curr_offset + padding + size > s->buf_len) {
+    padding = calc_padding_with_header(curr_addr, (uintptr_t)alignment, sizeof(Strict_Stack_Alloc_Header));
+    if(padding > s->buf_len - s->curr_offset || size > s->buf_len - s->curr_offset - padding) {
         return NULL;
     }
 
-    s->prev_offset = s->curr_offset;
-    s->curr_offset += padding;
-
     next_addr = curr_addr + (uintptr_t)padding;
-    header = (Stack_Alloc_Header *)(next_addr - sizeof(Stack_Alloc_Header));
-    header->padding = (uint8_t)padding;
+    header = (Strict_Stack_Alloc_Header *)(next_addr - sizeof(Strict_Stack_Alloc_Header));
+    header->padding = padding;
+    // A free restores this as the previous offset, so it has to be the one from before this allocation
     header->prev_offset = s->prev_offset;
 
+    s->prev_offset = s->curr_offset;
+    s->curr_offset += padding;
+
     s->curr_offset += size;
 
     return memset((void *)next_addr, 0, size);
 }
 
-void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size, size_t alignment) {
+void *strict_stack_resize_align(Strict_Stack *s, void *ptr, size_t old_size, size_t new_size, size_t alignment) {
     if(ptr == NULL) {
-        return stack_alloc_align(s, new_size, alignment);
+        return strict_stack_alloc_align(s, new_size, alignment);
     } else if (new_size == 0) {
-        stack_free(s, ptr);
+        strict_stack_free(s, ptr);
         return NULL;
     } else {
         uintptr_t start, end, curr_addr, prev_offset;
         size_t min_size = old_size < new_size? old_size : new_size;
-        Stack_Alloc_Header *header;
+        Strict_Stack_Alloc_Header *header;
         void *new_ptr;
 
         start = (uintptr_t)s->buf;
@@ -85,18 +51,27 @@ void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size,
             return NULL;
         }
 
-        header = (Stack_Alloc_Header *)(curr_addr - sizeof(Stack_Alloc_Header));
+        header = (Strict_Stack_Alloc_Header *)(curr_addr - sizeof(Strict_Stack_Alloc_Header));
         prev_offset = (size_t)(curr_addr - (uintptr_t)header->padding - start);
 
-        if (old_size == min_size) {
+        if (new_size <= old_size) {
             return ptr;
         }
 
-        if(prev_offset != s->prev_offset) {
-            new_ptr = stack_alloc_align(s, new_size, alignment);
-        } else {
-            new_ptr = (void *)(curr_addr + (uintptr_t)new_size);
-            s->curr_offset = (size_t)(curr_addr + new_size - start);
+        if(prev_offset == s->prev_offset) {
+            // The last block grows in place as long as it stays within the buffer
+            size_t offset = (size_t)(curr_addr - start);
+
+            if(new_size <= s->buf_len - offset) {
+                s->curr_offset = offset + new_size;
+                memset((void *)(curr_addr + old_size), 0, new_size - old_size);
+                return ptr;
+            }
+        }
+
+        new_ptr = strict_stack_alloc_align(s, new_size, alignment);
+        if(new_ptr == NULL) {
+            return NULL;
         }
 
         memmove(new_ptr, ptr, min_size);
@@ -104,18 +79,18 @@ void *stack_resize_align(Stack *s, void *ptr, size_t old_size, size_t new_size,
     }
 }
 
-void *stack_resize(Stack *s, void *ptr, size_t old_size, size_t new_size) {
-    return stack_resize_align(s, ptr, old_size, new_size, DEFAULT_ALIGNMENT);
+void *strict_stack_resize(Strict_Stack *s, void *ptr, size_t old_size, size_t new_size) {
+    return strict_stack_resize_align(s, ptr, old_size, new_size, DEFAULT_ALIGNMENT);
 }
 
-void *stack_alloc(Stack *s, size_t size) {
-    return stack_alloc_align(s, size, DEFAULT_ALIGNMENT);
+void *strict_stack_alloc(Strict_Stack *s, size_t size) {
+    return strict_stack_alloc_align(s, size, DEFAULT_ALIGNMENT);
 }
 
-void stack_free(Stack *s, void *ptr) {
+void strict_stack_free(Strict_Stack *s, void *ptr) {
     if(ptr != NULL) {
         uintptr_t start, end, curr_addr;
-        Stack_Alloc_Header *header;
+        Strict_Stack_Alloc_Header *header;
         size_t prev_offset;
 
         start = (uintptr_t)s->buf;
@@ -132,7 +107,7 @@ void stack_free(Stack *s, void *ptr) {
             return;
         }
 
-        header = (Stack_Alloc_Header *)(curr_addr + sizeof(Stack_Alloc_Header));
+        header = (Strict_Stack_Alloc_Header *)(curr_addr - sizeof(Strict_Stack_Alloc_Header));
         prev_offset = (size_t)(curr_addr - (uintptr_t)header->padding - start);
 
         if(prev_offset != s->prev_offset) {
@@ -145,12 +120,12 @@ void stack_free(Stack *s, void *ptr) {
     }
 }
 
-void stack_free_all(Stack *s) {
+void strict_stack_free_all(Strict_Stack *s) {
     s->curr_offset = 0;
     s->prev_offset = 0;
 }
 
-void stack_init(Stack *s, void *backing_buffer, size_t backing_buffer_length) {
+void strict_stack_init(Strict_Stack *s, void *backing_buffer, size_t backing_buffer_length) {
     s->buf = (unsigned char *) backing_buffer;
     s->buf_len = backing_buffer_length;
     s->curr_offset = 0;